@@ -20,6 +20,10 @@
  */
 
 
+#include <mutex>
+#include <sstream>
+#include <tuple>
+
 #include "app.hpp"
 #include "utils.hpp"
 #include "mapping.hpp"
@@ -30,15 +34,20 @@
 #include "overlap_checks.hpp"
 #include "rted.hpp"
 #include "gted.hpp"
+#include "helix_tree.hpp"
+#include "coarse_ted.hpp"
+#include "ted_cache.hpp"
 #include "overlap_checks.hpp"
 
 #define ARGS_HELP                           {"-h", "--help"}
 #define ARGS_TARGET_STRUCTURE               {"-gs", "--target-structure"}
 #define ARGS_TEMPLATE_STRUCTURE             {"-ts", "--template-structure"}
 #define ARGS_TEMPLATE_STRUCTURE_FILE_TYPE   "--file-format"
+#define ARGS_TEMPLATES                      {"--templates"}
 #define ARGS_ALL                            {"-a", "--all"}
 #define ARGS_ALL_OVERLAPS                   "--overlaps"
 #define ARGS_TED                            {"-t", "--ted"}
+#define ARGS_TED_STRATEGIES                 "--strategies"
 #define ARGS_DRAW                           {"-d", "--draw"}
 #define ARGS_DRAW_OVERLAPS                  "--overlaps"
 #define ARGS_ROTATE_BRANCHES                {"-r", "--rotate"}
@@ -46,6 +55,12 @@
 #define ARGS_DEBUG                          {"--debug"}
 #define ARGS_NUMBERING                       {"-n", "--numbering"}
 #define ARGS_LABELS_TEMPLATE                 {"-l", "--labels-template"}
+#define ARGS_THREADS                        {"--threads"}
+#define ARGS_MAX_DISTANCE                   {"--max-distance"}
+#define ARGS_COSTS                          {"--costs"}
+#define ARGS_STEMS                          {"--stems"}
+#define ARGS_COARSE                         {"--coarse"}
+#define ARGS_CACHE                          {"--cache"}
 
 #define COLORED_FILENAME_EXTENSION          ".colored"
 
@@ -54,12 +69,35 @@
 using namespace std;
 
 
+/**
+ * name of TED mode in arguments print and TED cache keys
+ */
+static const char* ted_mode_name(
+                                 app::ted_mode mode)
+{
+    switch (mode)
+    {
+        case app::ted_stems:
+            return "stems";
+        case app::ted_coarse:
+            return "coarse";
+        default:
+            return "exact";
+    }
+}
+
 struct app::arguments
 {
     rna_tree templated; // template
     rna_tree matched; // target
+    vector<template_files> templates; // templates to rank, instead of templated
     bool rotate_branches = false;
     bool labels_template = false;
+    size_t threads = 1;
+    size_t max_distance = GTED_NO_MAX_DISTANCE;
+    shared_ptr<const ted_costs> costs; // nullptr == default costs
+    ted_mode mode = ted_exact;
+    string cache; // directory of cached mappings, empty == no cache
     
     struct
     {
@@ -71,6 +109,7 @@ struct app::arguments
     {
         bool run = false;
         string mapping;
+        string strategies; // strategy table reused by reruns
     } ted;
     struct
     {
@@ -118,14 +157,29 @@ void app::run(
     
     INFO("BEG: APP");
     
-    print(args);
     bool rted = args.all.run || args.ted.run || args.traveler.run;
     bool draw = args.all.run || args.draw.run;
     bool overlaps = args.all.overlap_checks || args.draw.overlap_checks;
     mapping map;
     string img_out = args.all.file;
     
-    map = run_ted(args.templated, args.matched, rted, args.ted.mapping);
+    if (!args.templates.empty())
+    {
+        size_t best = rank_templates(args.templates, args.matched, args.cache, args.threads, args.max_distance, args.costs, args.mode);
+        
+        if (!rted && !draw)
+        {
+            INFO("END: APP");
+            return;
+        }
+        // continue with the nearest template
+        const template_files& t = args.templates[best];
+        args.templated = create_template(t.image, t.type, t.fasta);
+    }
+    
+    print(args);
+    
+    map = run_ted(args.templated, args.matched, rted, args.ted.mapping, args.ted.strategies, args.cache, args.threads, args.max_distance, args.costs, args.mode);
     
     if (args.draw.run)
     {
@@ -143,36 +197,132 @@ mapping app::run_ted(
                      rna_tree& templated,
                      rna_tree& matched,
                      bool run,
-                     const std::string& mapping_file)
+                     const std::string& mapping_file,
+                     const std::string& strategies_file,
+                     const std::string& cache_dir,
+                     size_t threads,
+                     size_t max_distance,
+                     std::shared_ptr<const ted_costs> costs,
+                     ted_mode mode,
+                     size_t* ted_distance)
 {
     APP_DEBUG_FNAME;
     
     try
     {
         mapping mapping;
+        // TED distance of the mode, mapping.distance counts just inserted and deleted nodes
+        size_t distance = 0;
+        auto set_distance = [&distance, ted_distance]() {
+            if (ted_distance != nullptr)
+                *ted_distance = distance;
+        };
+        unique_ptr<ted_cache> cache;
+        string cache_key;
+        // NDJSON mapping file of exact TED is written as it is backtracked
+        unique_ptr<mapping_writer> writer;
+        bool ndjson = is_ndjson_file(mapping_file);
+        
+        if (run && !cache_dir.empty())
+        {
+            cache.reset(new ted_cache(cache_dir));
+            cache_key = cache->get_key(templated, matched,
+                                       string(ted_mode_name(mode)) + "\n" + (costs ? costs->to_string() : "default"),
+                                       costs.get());
+            if (cache->load(cache_key, mapping, distance))
+            {
+                INFO("TED cache hit for RNAs %s and %s: %s", templated.name(), matched.name(), cache->get_file(cache_key));
+                
+                if (distance > max_distance)
+                    throw aplication_error("RNAs %s and %s are too distant: distance exceeds max distance %s",
+                                           templated.name(), matched.name(), max_distance).with(ERROR_TOO_DISTANT);
+                
+                if (!mapping_file.empty())
+                    save_tree_mapping_table(mapping_file, mapping, ndjson);
+                set_distance();
+                return mapping;
+            }
+            INFO("TED cache miss for RNAs %s and %s: %s", templated.name(), matched.name(), cache->get_file(cache_key));
+        }
         
-        if (run)
+        if (run && mode == ted_coarse)
         {
+            coarse_ted c(templated, matched);
+            c.run(threads);
+            mapping = c.get_mapping();
+            distance = mapping.distance;
             
-           
-            rted r(templated, matched); //Gets a strategy for decomposing a tree
-            r.run();
+            if (distance > max_distance)
+                throw aplication_error("RNAs %s and %s are too distant: distance exceeds max distance %s",
+                                       templated.name(), matched.name(), max_distance).with(ERROR_TOO_DISTANT);
+        }
+        else if (run)
+        {
+            // with stems, TED runs on helix-compressed trees
+            bool stems = mode == ted_stems;
+            unique_ptr<helix_tree> helices1, helices2;
+            const rna_tree* tree1 = &templated;
+            const rna_tree* tree2 = &matched;
             
-            gted g(templated, matched); //Computes mapping and ditstanve based on RTED's strategy (faster than using GTED itself)
-            g.run(r.get_strategies());
-    
-            mapping = g.get_mapping();
+            if (stems)
+            {
+                helices1.reset(new helix_tree(templated));
+                helices2.reset(new helix_tree(matched));
+                tree1 = &helices1->get_tree();
+                tree2 = &helices2->get_tree();
+                INFO("Running stem-aware TED on helix trees of sizes %s and %s", tree1->size(), tree2->size());
+            }
+            
+            gted g(*tree1, *tree2); //Computes mapping and ditstanve based on RTED's strategy (faster than using GTED itself)
+            if (stems)
+                g.set_costs(make_shared<helix_costs>());
+            else
+                g.set_costs(costs);
+            if (max_distance != GTED_NO_MAX_DISTANCE)
+            {
+                size_t bound = g.distance_lower_bound(max_distance);
+                
+                if (bound > max_distance)
+                    throw aplication_error("RNAs %s and %s are too distant: distance is at least %s, max distance is %s",
+                                           templated.name(), matched.name(), bound, max_distance).with(ERROR_TOO_DISTANT);
+                g.set_max_distance(max_distance);
+            }
             
-            if (!mapping_file.empty())
-                save_tree_mapping_table(mapping_file, mapping);
+            strategy_table_type strategies = compute_strategies(*tree1, *tree2, strategies_file, threads);
+            g.run(strategies, threads);
+            strategies.clear();
+            distance = g.get_distance();
+            
+            if (distance > max_distance)
+                throw aplication_error("RNAs %s and %s are too distant: distance exceeds max distance %s",
+                                       templated.name(), matched.name(), max_distance).with(ERROR_TOO_DISTANT);
+    
+            if (ndjson && !stems)
+                writer.reset(new mapping_writer(mapping_file));
+            mapping = g.get_mapping(writer.get());
+            if (writer)
+                writer->finish();
+            if (stems)
+                mapping = helix_tree::expand(mapping, *helices1, *helices2);
         }
         else
         {
             INFO("skipping rted run, returning default mapping");
+            return mapping;
         }
         
+        if (cache)
+            cache->save(cache_key, mapping, distance);
+        if (!mapping_file.empty() && !writer)
+            save_tree_mapping_table(mapping_file, mapping, ndjson);
+        set_distance();
+        
         return mapping;
     }
+    catch (const aplication_error& e)
+    {
+        throw;
+    }
     catch (const my_exception& e)
     {
         throw aplication_error("Tree-edit-distance computation failed: %s", e).with(ERROR_TED);
@@ -180,6 +330,170 @@ mapping app::run_ted(
     
 }
 
+/* static */ strategy_table_type app::compute_strategies(
+                                                         const rna_tree& templated,
+                                                         const rna_tree& matched,
+                                                         const std::string& strategies_file,
+                                                         size_t threads)
+{
+    strategy_table_type strategies;
+    
+    if (!strategies_file.empty() && exist_file(strategies_file))
+    {
+        strategies = load_strategy_table(strategies_file);
+        
+        // every strategy table gives the same mapping, only its size has to fit
+        if (strategies.rows() == templated.size() && strategies.cols() == matched.size())
+        {
+            INFO("Strategies loaded from %s, skipping rted run", strategies_file);
+            return strategies;
+        }
+        WARN("Strategies in %s do not fit trees of sizes %s and %s, recomputing them",
+             strategies_file, templated.size(), matched.size());
+        strategies.clear();
+    }
+    
+    strategies = rted::compute_strategies(templated, matched, threads); //Gets a strategy for decomposing a tree
+    
+    if (!strategies_file.empty())
+        save_strategy_table(strategies_file, strategies, true);
+    
+    return strategies;
+}
+
+size_t app::rank_templates(
+                           const std::vector<template_files>& templates,
+                           rna_tree& matched,
+                           const std::string& cache_dir,
+                           size_t threads,
+                           size_t max_distance,
+                           std::shared_ptr<const ted_costs> costs,
+                           ted_mode mode)
+{
+    APP_DEBUG_FNAME;
+    
+    INFO("BEG: Ranking %s templates", templates.size());
+    
+    struct result
+    {
+        size_t index;
+        string name;
+        size_t distance = GTED_NO_MAX_DISTANCE;
+        bool too_distant = false;
+        string error;
+    };
+    vector<result> results(templates.size());
+    // exact TED without cache shares target precomputation by all templates
+    bool shared_target = mode == ted_exact && cache_dir.empty();
+    shared_ptr<gted_tree> target;
+    mutex create_lock;
+    
+    if (shared_target)
+        target = make_shared<gted_tree>(matched);
+    
+    auto compute = [&](size_t i) {
+        const template_files& t = templates[i];
+        result& res = results[i];
+        rna_tree templated;
+        
+        res.index = i;
+        res.name = t.image;
+        try
+        {
+            {
+                // template files are parsed one at a time
+                lock_guard<mutex> guard(create_lock);
+                templated = create_template(t.image, t.type, t.fasta);
+            }
+            res.name = templated.name();
+            
+            if (!shared_target)
+            {
+                try
+                {
+                    run_ted(templated, matched, true, "", "", cache_dir, 1, max_distance, costs, mode, &res.distance);
+                }
+                catch (const aplication_error& e)
+                {
+                    if (e.get_return_status() != ERROR_TOO_DISTANT)
+                        throw;
+                    res.too_distant = true;
+                }
+                return;
+            }
+            
+            gted g(templated, target);
+            g.set_costs(costs);
+            if (max_distance != GTED_NO_MAX_DISTANCE)
+            {
+                res.distance = g.distance_lower_bound(max_distance);
+                res.too_distant = res.distance > max_distance;
+                if (res.too_distant)
+                    return;
+                g.set_max_distance(max_distance);
+            }
+            
+            g.run(compute_strategies(templated, matched));
+            
+            res.distance = g.get_distance();
+            res.too_distant = res.distance > max_distance;
+        }
+        catch (const my_exception& e)
+        {
+            res.error = e.what();
+        }
+    };
+    
+    {
+        task_pool pool(threads);
+        task_pool::task_group group(pool);
+        
+        for (size_t i = 0; i < templates.size(); ++i)
+            group.run([&compute, i]() {
+                compute(i);
+            });
+        group.wait();
+    }
+    
+    // failed and too distant templates are ranked last
+    auto rank = [](const result& res) {
+        return make_tuple(!res.error.empty(), res.too_distant, res.distance, res.index);
+    };
+    sort(results.begin(), results.end(), [&rank](const result& r1, const result& r2) {
+        return rank(r1) < rank(r2);
+    });
+    
+    ostringstream table;
+    table << "RANK\tDISTANCE\tTEMPLATE\tFILE" << endl;
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const result& res = results[i];
+        
+        table << i + 1 << '\t';
+        if (!res.error.empty())
+            table << '-';
+        else if (res.too_distant)
+            table << '>' << max_distance;
+        else
+            table << res.distance;
+        table << '\t' << res.name << '\t' << templates[res.index].image << endl;
+        
+        if (!res.error.empty())
+            ERR("Template %s failed: %s", templates[res.index].image, res.error);
+    }
+    cout << table.str();
+    
+    INFO("END: Ranking %s templates", templates.size());
+    
+    if (results.empty() || !results[0].error.empty())
+        throw aplication_error("No template could be compared with RNA %s", matched.name()).with(ERROR_TED);
+    if (results[0].too_distant)
+        throw aplication_error("All templates are too distant from RNA %s, max distance is %s",
+                               matched.name(), max_distance).with(ERROR_TOO_DISTANT);
+    
+    return results[0].index;
+}
+
 #include "iostream"
 void app::run_drawing(
                       rna_tree& templated,
@@ -309,6 +623,60 @@ rna_tree app::create_template(
 
 
 
+/* static */ vector<app::template_files> app::read_templates(
+                                                             const std::string& path,
+                                                             const std::string& templatetype)
+{
+    APP_DEBUG_FNAME;
+    
+    vector<template_files> templates;
+    
+    if (is_directory(path))
+    {
+        vector<string> files = list_directory(path);
+        const string ext = ".fasta";
+        
+        for (const string& fasta : files)
+        {
+            if (fasta.size() <= ext.size() ||
+                fasta.compare(fasta.size() - ext.size(), ext.size(), ext) != 0)
+                continue;
+            
+            string stem = fasta.substr(0, fasta.size() - ext.size() + 1);
+            auto image = find_if(files.begin(), files.end(), [&stem, &fasta](const string& file) {
+                return file != fasta && file.compare(0, stem.size(), stem) == 0;
+            });
+            if (image != files.end())
+                templates.push_back({path + "/" + *image, templatetype, path + "/" + fasta});
+            else
+                WARN("Template image for %s/%s not found", path, fasta);
+        }
+    }
+    else
+    {
+        istringstream in(read_file(path));
+        string line;
+        
+        while (getline(in, line))
+        {
+            istringstream fields(line);
+            template_files t;
+            
+            t.type = templatetype;
+            if (!(fields >> t.image) || t.image[0] == '#')
+                continue;
+            if (!(fields >> t.fasta))
+                throw wrong_argument_exception("Template list %s: DBN file expected after '%s'", path, t.image);
+            templates.push_back(t);
+        }
+    }
+    
+    if (templates.empty())
+        throw wrong_argument_exception("No templates found in %s", path);
+    
+    return templates;
+}
+
 
 void app::usage(
                 const string& appname)
@@ -344,12 +712,21 @@ void app::usage(
     << " [" << ARGS_TEMPLATE_STRUCTURE_FILE_TYPE << " FILE_FORMAT]"
     << " IMAGE_FILE DBN_FILE"
     << endl
+    << appname
+    << " [OPTIONS]"
+    << " <" << get_args(ARGS_TARGET_STRUCTURE) << ">"
+    << " DBN_FILE"
+    << " <" << get_args(ARGS_TEMPLATES) << ">"
+    << " [" << ARGS_TEMPLATE_STRUCTURE_FILE_TYPE << " FILE_FORMAT]"
+    << " TEMPLATE_LIST|TEMPLATE_DIRECTORY"
+    << endl
     << endl
     << "OPTIONS:" << endl
     << "\t[" << get_args(ARGS_ALL)
     << "] [" << ARGS_ALL_OVERLAPS << "] FILE_OUT"
     << endl
-    << "\t[" << get_args(ARGS_TED) << "] FILE_MAPPING_OUT"
+    << "\t[" << get_args(ARGS_TED)
+    << "] [" << ARGS_TED_STRATEGIES << " FILE_STRATEGIES] FILE_MAPPING_OUT"
     << endl
     << "\t[" << get_args(ARGS_DRAW)
     << "] [" << ARGS_DRAW_OVERLAPS << "] FILE_MAPPING_IN FILE_OUT"
@@ -361,6 +738,18 @@ void app::usage(
     << "\t[" << get_args(ARGS_NUMBERING) << "]"
     << endl
     << "\t[" << get_args(ARGS_LABELS_TEMPLATE) << "]"
+    << endl
+    << "\t[" << get_args(ARGS_THREADS) << " N]"
+    << endl
+    << "\t[" << get_args(ARGS_MAX_DISTANCE) << " K]"
+    << endl
+    << "\t[" << get_args(ARGS_COSTS) << " FILE_COSTS]"
+    << endl
+    << "\t[" << get_args(ARGS_STEMS) << "]"
+    << endl
+    << "\t[" << get_args(ARGS_COARSE) << "]"
+    << endl
+    << "\t[" << get_args(ARGS_CACHE) << " CACHE_DIRECTORY]"
     << endl;
 }
 
@@ -379,18 +768,28 @@ void app::print(
          "ted:\n"
          "\trun=%s\n"
          "\tmapping-file=%s\n"
+         "\tstrategies-file=%s\n"
          "draw:\n"
          "\trun=%s\n"
          "\toverlaps=%s\n"
          "\tmapping-file=%s\n"
          "\timage-file=%s"
-         "\rotate=%s\n",
+         "\rotate=%s\n"
+         "threads=%s\n"
+         "max-distance=%s\n"
+         "costs=%s\n"
+         "mode=%s\n"
+         "cache=%s\n",
          args.templated.name(), args.templated.print_tree(false),
          args.matched.name(), args.matched.print_tree(false),
          args.all.run, args.all.file, args.all.overlap_checks,
-         args.ted.run, args.ted.mapping,
+         args.ted.run, args.ted.mapping, args.ted.strategies,
          args.draw.run, args.draw.overlap_checks, args.draw.mapping, args.draw.file,
-         args.rotate_branches);
+         args.rotate_branches, args.threads,
+         args.max_distance == GTED_NO_MAX_DISTANCE ? "none" : to_string(args.max_distance),
+         args.costs ? "custom" : "default",
+         ted_mode_name(args.mode),
+         args.cache.empty() ? "none" : args.cache);
     
     
 }
@@ -471,6 +870,18 @@ void app::print(
                 a.templated = app::create_template(templatefile, templatetype, fastafile);
                 i += 2;
             }
+            else if (is_argument(ARGS_TEMPLATES))
+            {
+                DEBUG("arg templates");
+                string templatetype = "crw";
+                if (nextarg() == ARGS_TEMPLATE_STRUCTURE_FILE_TYPE)
+                {
+                    templatetype = args.at(i + 2);
+                    i += 2;
+                }
+                a.templates = app::read_templates(args.at(i + 1), templatetype);
+                ++i;
+            }
             else if (is_argument(ARGS_ALL))
             {
                 DEBUG("arg all");
@@ -492,6 +903,11 @@ void app::print(
             {
                 DEBUG("arg ted");
                 a.ted.run = true;
+                if (nextarg() == ARGS_TED_STRATEGIES)
+                {
+                    a.ted.strategies = args.at(i + 2);
+                    i += 2;
+                }
                 a.ted.mapping = args.at(i + 1);
                 i += 1;
             }
@@ -550,6 +966,61 @@ void app::print(
                 a.labels_template = true;
 
             }
+            else if (is_argument(ARGS_THREADS))
+            {
+                DEBUG("arg threads");
+                try
+                {
+                    int threads = stoi(args.at(i + 1));
+                    if (threads < 0)
+                        throw invalid_argument("negative");
+                    // 0 == all cores
+                    a.threads = threads != 0 ? threads : max(thread::hardware_concurrency(), 1u);
+                }
+                catch (const logic_error&)
+                {
+                    throw wrong_argument_exception("Number of threads expected after %s, got '%s'", arg, args.at(i + 1));
+                }
+                ++i;
+            }
+            else if (is_argument(ARGS_MAX_DISTANCE))
+            {
+                DEBUG("arg max-distance");
+                try
+                {
+                    long long k = stoll(args.at(i + 1));
+                    if (k < 0)
+                        throw invalid_argument("negative");
+                    a.max_distance = k;
+                }
+                catch (const logic_error&)
+                {
+                    throw wrong_argument_exception("Non-negative distance expected after %s, got '%s'", arg, args.at(i + 1));
+                }
+                ++i;
+            }
+            else if (is_argument(ARGS_COSTS))
+            {
+                DEBUG("arg costs");
+                a.costs = make_shared<ted_costs>(ted_costs::load(args.at(i + 1)));
+                ++i;
+            }
+            else if (is_argument(ARGS_STEMS))
+            {
+                DEBUG("arg stems");
+                a.mode = ted_stems;
+            }
+            else if (is_argument(ARGS_COARSE))
+            {
+                DEBUG("arg coarse");
+                a.mode = ted_coarse;
+            }
+            else if (is_argument(ARGS_CACHE))
+            {
+                DEBUG("arg cache");
+                a.cache = args.at(i + 1);
+                ++i;
+            }
             else
             {
                 throw wrong_argument_exception("Wrong parameter no.%i: '%s'; try running %s --help for more arguments details",
@@ -557,8 +1028,10 @@ void app::print(
             }
         }
         
-        if (a.templated == rna_tree() || a.matched == rna_tree())
+        if ((a.templated == rna_tree() && a.templates.empty()) || a.matched == rna_tree())
             throw wrong_argument_exception("RNA structures are missing, try running %s --help for more arguments details", args[0]);
+        if (a.mode != ted_exact && a.costs)
+            throw wrong_argument_exception("--stems and --coarse cannot be combined with --costs");
 
         a.fill_default();
 
@@ -6,7 +6,7 @@ LOG_FILE                = "/tmp/traveler.log"
 
 CC                      = g++
 DEBUG                   = -g -Wall
-CFLAGS                  = -std=gnu++11 -c ${DEBUG} ${RELEASE} -I${ROOTDIR}/include/ -I${ROOTDIR}/include/tests/ -I${ROOTDIR}/../assets/json/ -DLOG_FILE=\\\"${LOG_FILE}\\\"
-LFLAGS                  = ${DEBUG} ${RELEASE} -std=c++11
+CFLAGS                  = -std=gnu++11 -pthread -c ${DEBUG} ${RELEASE} -I${ROOTDIR}/include/ -I${ROOTDIR}/include/tests/ -I${ROOTDIR}/../assets/json/ -DLOG_FILE=\\\"${LOG_FILE}\\\"
+LFLAGS                  = ${DEBUG} ${RELEASE} -std=c++11 -pthread
 SHELL                   = /bin/bash -o pipefail
 
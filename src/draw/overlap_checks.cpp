@@ -36,7 +36,7 @@ overlap_checks::overlaps overlap_checks::run(
     
     INFO("BEG: Checking overlaps for RNA %s", rna.name());
     
-    edges vec = get_edges(rna);
+    edges vec = get_edges(rna_tree_snapshot(rna));
     overlaps overlaps = run(vec);
     //overlaps overlaps = get_overlaps(vec, vec);
     
@@ -44,26 +44,23 @@ overlap_checks::overlaps overlap_checks::run(
 }
 
 overlap_checks::edges overlap_checks::get_edges(
-                                                rna_tree& rna)
+                                                const rna_tree_snapshot& rna)
 {
     APP_DEBUG_FNAME;
     
     edges vec;
     edge e;
+    // the first residue is 5' end
+    size_t r = 1;
     
-#define get_p() it->at(it.label_index()).p
-#define get_id() it->id()
-
-    rna_tree::pre_post_order_iterator it = ++rna.begin_pre_post();
-    e.p1 = get_p();
-    e.id1 = get_id();
+    e.p1 = rna.p(r);
+    e.id1 = rna.id[rna.node[r]];
     
-    for (++it; it != rna.end_pre_post(); ++it)
+    for (++r; r < rna.residues(); ++r)
     {
-        //assert(it->initiated_points());
-        if (it->initiated_points()) {
-            e.p2 = get_p();
-            e.id2 = get_id();
+        if (rna.initiated(rna.node[r])) {
+            e.p2 = rna.p(r);
+            e.id2 = rna.id[rna.node[r]];
             vec.push_back(e);
             e.p1 = e.p2;
             e.id1 = e.id2;
@@ -71,8 +68,6 @@ overlap_checks::edges overlap_checks::get_edges(
     }
 
     return vec;
-#undef get_p
-#undef get_id
 }
 
 
@@ -6,54 +6,42 @@
 
 using namespace std;
 
-void pseudoknots::find_pseudoknot_segments(rna_tree::pre_post_order_iterator begin, rna_tree::pre_post_order_iterator end){
+void pseudoknots::find_pseudoknot_segments(rna_tree &rna){
 
+    rna_tree_snapshot snapshot(rna);
+    // unpaired residue of each pseudoknot waiting for its partner
+    vector<size_t> open(snapshot.residues() + 1, RNA_TREE_SNAPSHOT_NONE);
+    vector<pair<size_t, size_t>> residue_pairs;
 
-//    int i=0;
-//    for (auto it = begin; it != end; it++){
-//        cout << i++ << " " << it->at(0).pseudoknot << "\n";
-//    }
-
-    int ix_begin = 0;
-    vector<rna_tree::pre_post_order_iterator> processed_pns;
-    while(begin != end)
+    //pseudoknots can be only at position of unpaired (in terms of non-pseudoknot pairing) nucleotides,
+    //each of them is paired with the next one of the same pseudoknot
+    for (size_t r = 0; r < snapshot.residues(); ++r)
     {
-        if (begin->size() == 1 && std::find(processed_pns.begin(), processed_pns.end(), begin) == processed_pns.end()) //pseudoknots can be only at position of unpaired (in terms of non-pseudoknot pairing) nucleotides
-        //for (int i = 0; i < begin->size(); ++i)
-//        for(auto&& l: begin->labels)
+        size_t pk = snapshot.pseudoknot[r];
+
+        if (pk == 0 || snapshot.paired(snapshot.node[r]))
+            continue;
+        if (open[pk] == RNA_TREE_SNAPSHOT_NONE)
+            open[pk] = r;
+        else
         {
-            //auto l = (*begin)[i];
-            auto l = (*begin)[0];
-            if(!l.pseudoknot.empty())
-            {
-                auto rest = begin;
-                auto ix_rest = ix_begin;
-                ++rest; ++ix_rest;
-
-                while(rest != end)
-                {
-                    if (rest->size()  == 1 && std::find(processed_pns.begin(), processed_pns.end(), rest) == processed_pns.end())
-                    //for (int j = 0; j < rest->size(); ++j)
-//                    for(auto&& ll: rest->labels)
-                    {
-                        //auto ll = (*rest)[j];
-                        auto ll = (*rest)[0];
-                        if(ll.pseudoknot == l.pseudoknot)
-                        {
-                            this->pairs.push_back(make_pair(begin, rest));
-                            processed_pns.push_back(begin);
-                            processed_pns.push_back(rest);
-                            break;
-                        }
-                    }
-                    ++rest;
-                }
-            }
+            residue_pairs.push_back(make_pair(open[pk], r));
+            open[pk] = RNA_TREE_SNAPSHOT_NONE;
         }
-
-        ++begin; ++ix_begin;
     }
 
+    if (residue_pairs.empty())
+        return;
+
+    sort(residue_pairs.begin(), residue_pairs.end());
+
+    vector<rna_tree::pre_post_order_iterator> residues;
+    residues.reserve(snapshot.residues());
+    for (auto it = rna.begin_pre_post(); it != rna.end_pre_post(); ++it)
+        residues.push_back(it);
+    for (const auto& p : residue_pairs)
+        this->pairs.push_back(make_pair(residues[p.first], residues[p.second]));
+
     if (this->pairs.size() > 0){
         pseudoknot_segment s = {make_pair(this->pairs[0].first, this->pairs[0].first), make_pair(this->pairs[0].second, this->pairs[0].second)};
         for (int i = 1; i < this->pairs.size(); ++i){
@@ -206,7 +194,7 @@ bool curves_share_point(vector<line> l1, vector<line> l2) {
 
 pseudoknots::pseudoknots(rna_tree &rna, const document_settings &settings) {
     this->font_size = settings.font_size;
-    this->find_pseudoknot_segments(rna.begin_pre_post(), rna.end_pre_post());
+    this->find_pseudoknot_segments(rna);
 
     if (this->segments.size() == 0) return;
 
@@ -23,6 +23,8 @@
 #define APP_HPP
 
 #include "types.hpp"
+#include "strategy.hpp"
+#include "ted_costs.hpp"
 
 class rna_tree;
 class mapping;
@@ -35,6 +37,27 @@ class app
 private:
     struct arguments;
     
+    /**
+     * template given by files, see create_template()
+     */
+    struct template_files
+    {
+        std::string image;
+        std::string type;
+        std::string fasta;
+    };
+    
+public:
+    /**
+     * how run_ted computes mapping
+     */
+    enum ted_mode
+    {
+        ted_exact,      // node-level TED
+        ted_stems,      // stem-aware TED on helix trees, see helix_costs
+        ted_coarse,     // helix-level TED refined on node level, see coarse_ted
+    };
+    
 public:
     /**
      * run app with arguments from command line
@@ -60,12 +83,64 @@ private:
     /**
      * run tree-edit-distance algorithm
      * returns mapping between templated (template) and matched (target) tree
+     *
+     * if distance exceeds max_distance, aplication_error
+     * with ERROR_TOO_DISTANT is thrown before computing mapping;
+     * nullptr `costs` are default ones
+     *
+     * ted_stems and ted_coarse modes do not use `costs`,
+     * ted_coarse mode does not use `strategies_file`
+     *
+     * with non-empty `cache_dir`, mapping is looked up in ted_cache
+     * first and computed mapping is stored there
+     *
+     * TED distance of `mode` is stored to non-null `distance`
      */
     mapping run_ted(
                     rna_tree& templated,
                     rna_tree& matched,
                     bool save,
-                    const std::string& mapping_file);
+                    const std::string& mapping_file,
+                    const std::string& strategies_file,
+                    const std::string& cache_dir,
+                    size_t threads,
+                    size_t max_distance,
+                    std::shared_ptr<const ted_costs> costs,
+                    ted_mode mode,
+                    size_t* distance = nullptr);
+    
+    /**
+     * compute strategy table for gted, optimal one (by rted)
+     * or fixed if computing optimal one is not worth it
+     *
+     * if `strategies_file` is given, table is loaded from it when it
+     * fits the trees, otherwise computed table is saved to it (binary);
+     * rted runs in `threads` threads
+     */
+    static strategy_table_type compute_strategies(
+                                                  const rna_tree& templated,
+                                                  const rna_tree& matched,
+                                                  const std::string& strategies_file = "",
+                                                  size_t threads = 1);
+    
+    /**
+     * compute distances between `matched` and all templates, templates
+     * are processed in parallel in `threads` threads
+     *
+     * distance is that of `mode`; except for exact TED without cache,
+     * every template goes through run_ted, so ted_cache is used as well
+     *
+     * prints table of templates ranked by distance,
+     * returns index of the nearest template
+     */
+    size_t rank_templates(
+                          const std::vector<template_files>& templates,
+                          rna_tree& matched,
+                          const std::string& cache_dir,
+                          size_t threads,
+                          size_t max_distance,
+                          std::shared_ptr<const ted_costs> costs,
+                          ted_mode mode);
     
     /**
      * run drawing algorithm, visualized molecule will be saved
@@ -107,6 +182,15 @@ private:
                                      const std::string& templatetype,
                                      const std::string& fastafile);
     
+    /**
+     * read templates from list file, with lines 'IMAGE_FILE DBN_FILE',
+     * or from directory, where NAME.fasta is paired with the other
+     * file NAME.* as its image
+     */
+    static std::vector<template_files> read_templates(
+                                                      const std::string& path,
+                                                      const std::string& templatetype);
+    
     /**
      * print arguments
      */
@@ -121,6 +205,7 @@ private:
 #define ERROR_ARGUMENTS         101
 #define ERROR_TED               102
 #define ERROR_DRAW              103
+#define ERROR_TOO_DISTANT       104
 class aplication_error : public my_exception
 {
 public:
@@ -0,0 +1,185 @@
+#ifndef TRAVELER_BINARY_TABLE_HPP
+#define TRAVELER_BINARY_TABLE_HPP
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+
+#include "flat_table.hpp"
+#include "types.hpp"
+
+#define BINARY_TABLE_MAGIC          "TRVTABLE"
+#define BINARY_TABLE_VERSION        1
+#define BINARY_TABLE_HEADER_SIZE    32
+
+/**
+ * read-only memory-mapped table in binary format
+ *
+ *  format:
+ *      header:     magic "TRVTABLE", u32 version, u32 element width
+ *                  (1, 2, 4 or 8 bytes), u64 rows, u64 cols
+ *      payload:    rows * cols unsigned elements, row-major
+ *  all numbers are little-endian
+ */
+class binary_table
+{
+public:
+    /**
+     * map `filename`, throws io_exception if it is not a valid binary table
+     */
+    binary_table(
+                 const std::string& filename);
+    ~binary_table();
+
+    binary_table(const binary_table&) = delete;
+    binary_table& operator=(const binary_table&) = delete;
+
+public:
+    /**
+     * true if `filename` starts with binary table magic
+     */
+    static bool is_binary(
+                          const std::string& filename);
+
+    /**
+     * save `rows` x `cols` `table` of unsigned values (or values castable
+     * to size_t, accessed as table[i][j]) with elements of `width` bytes
+     */
+    template <typename table_type>
+    static void save(
+                     const std::string& filename,
+                     const table_type& table,
+                     size_t rows,
+                     size_t cols,
+                     size_t width);
+    /**
+     * read `filename` into `table` without mapping it, payload goes
+     * straight to memory of table; elements have to be `value_type`
+     * wide, `value_type` is stored as its unsigned value and wider
+     * elements need little-endian host
+     */
+    template <typename value_type>
+    static void read(
+                     const std::string& filename,
+                     flat_table<value_type>& table);
+    /**
+     * smallest element width for values up to `max_value`
+     */
+    static size_t width_for(
+                            uint64_t max_value);
+
+public:
+    inline size_t rows() const
+    {
+        return m;
+    }
+    inline size_t cols() const
+    {
+        return n;
+    }
+    inline size_t width() const
+    {
+        return w;
+    }
+    /**
+     * value at [i, j], whatever the element width is
+     */
+    uint64_t at(
+                size_t i,
+                size_t j) const;
+
+    /**
+     * zero-copy view of payload, elements have to be `value_type` wide
+     * and wider elements need little-endian host
+     */
+    template <typename value_type>
+    flat_table_view<const value_type> view() const;
+
+private:
+    /**
+     * check `header` of file of `length` bytes, returns error or nullptr
+     */
+    static const char* parse_header(
+                                    const uint8_t* header,
+                                    size_t length,
+                                    size_t& rows,
+                                    size_t& cols,
+                                    size_t& width);
+    /**
+     * open `filename` as `in` positioned at payload
+     */
+    static void open_payload(
+                             const std::string& filename,
+                             std::ifstream& in,
+                             size_t& rows,
+                             size_t& cols,
+                             size_t& width);
+    static void save(
+                     const std::string& filename,
+                     size_t rows,
+                     size_t cols,
+                     size_t width,
+                     const std::vector<uint8_t>& payload);
+    static void put(
+                    uint8_t* out,
+                    uint64_t value,
+                    size_t width);
+    static bool little_endian();
+
+private:
+    void* address = nullptr;
+    size_t length = 0;
+    const uint8_t* payload = nullptr;
+    size_t m = 0;
+    size_t n = 0;
+    size_t w = 0;
+};
+
+
+template <typename table_type>
+/* static */ void binary_table::save(
+                                     const std::string& filename,
+                                     const table_type& table,
+                                     size_t rows,
+                                     size_t cols,
+                                     size_t width)
+{
+    std::vector<uint8_t> payload(rows * cols * width);
+    uint8_t* out = payload.data();
+
+    for (size_t i = 0; i < rows; ++i)
+        for (size_t j = 0; j < cols; ++j, out += width)
+            put(out, size_t(table[i][j]), width);
+
+    save(filename, rows, cols, width, payload);
+}
+
+template <typename value_type>
+/* static */ void binary_table::read(
+                                     const std::string& filename,
+                                     flat_table<value_type>& table)
+{
+    std::ifstream in;
+    size_t rows, cols, width;
+
+    open_payload(filename, in, rows, cols, width);
+    if (width != sizeof(value_type))
+        throw io_exception("binary_table::read(%s) failed, elements are %s bytes wide, %s expected",
+                           filename, width, sizeof(value_type));
+    assert(width == 1 || little_endian());
+
+    table.resize(rows, cols);
+    if (!in.read(reinterpret_cast<char*>(table.data()), rows * cols * width))
+        throw io_exception("binary_table::read(%s) failed", filename);
+}
+
+template <typename value_type>
+flat_table_view<const value_type> binary_table::view() const
+{
+    assert(sizeof(value_type) == w && (w == 1 || little_endian()));
+
+    return flat_table_view<const value_type>(reinterpret_cast<const value_type*>(payload), m, n);
+}
+
+#endif /* !TRAVELER_BINARY_TABLE_HPP */
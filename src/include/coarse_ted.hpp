@@ -0,0 +1,97 @@
+#ifndef TRAVELER_COARSE_TED_HPP
+#define TRAVELER_COARSE_TED_HPP
+
+#include <vector>
+
+#include "rna_tree.hpp"
+#include "mapping.hpp"
+
+/**
+ * matched subtree pairs with at most this many cells
+ * (|subtree1| * |subtree2|) are refined by node-level TED
+ */
+#define COARSE_TED_REFINE_MAX_CELLS     (1 << 18)
+
+/**
+ * approximate TED in two levels
+ *
+ * first TED runs on helix_tree-s with compressed loops and helix_costs
+ * equal to node-level costs of not split helices and loop segments,
+ * i.e. mapping can only shorten them;
+ * then the largest pairs of matched subtrees which are small enough
+ * are recomputed by node-level TED, where it lowers the distance
+ *
+ * distance is never smaller than the exact one, mapping is valid
+ * TED mapping of original trees
+ */
+class coarse_ted
+{
+public:
+    typedef rna_tree::iterator iterator;
+
+public:
+    coarse_ted(
+               const rna_tree& _t1,
+               const rna_tree& _t2);
+
+    /**
+     * compute mapping, gted runs in `threads` threads;
+     * with `max_cells` == 0 mapping is not refined
+     */
+    void run(
+             size_t threads = 1,
+             size_t max_cells = COARSE_TED_REFINE_MAX_CELLS);
+
+    /**
+     * mapping of original trees, valid after run
+     */
+    inline const mapping& get_mapping() const
+    {
+        return map;
+    }
+    /**
+     * distance of helix-level mapping, before refinement
+     */
+    inline size_t get_coarse_distance() const
+    {
+        return coarse_distance;
+    }
+    /**
+     * number of refined subtree pairs
+     */
+    inline size_t get_refined() const
+    {
+        return refined;
+    }
+
+private:
+    /**
+     * subtree of `root` as a separate tree; its nodes have
+     * postorder ids relative to the first node of subtree
+     */
+    static rna_tree subtree(
+                            iterator root);
+    /**
+     * recompute mapping of subtrees of matched `v` and `w`,
+     * `distance` is the current one of the subtrees
+     */
+    void refine(
+                size_t v,
+                size_t w,
+                size_t distance,
+                size_t threads);
+
+private:
+    rna_tree t1, t2;
+    // postorder id -> node, first postorder id of its subtree
+    std::vector<iterator> nodes1, nodes2;
+    std::vector<size_t> first1, first2;
+    // postorder id -> matched postorder id of other tree or none
+    std::vector<size_t> to1, to2;
+
+    mapping map;
+    size_t coarse_distance = 0;
+    size_t refined = 0;
+};
+
+#endif /* !TRAVELER_COARSE_TED_HPP */
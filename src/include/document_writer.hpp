@@ -26,6 +26,7 @@
 #include <sstream>
 
 #include "rna_tree.hpp"
+#include "rna_tree_snapshot.hpp"
 #include "pseudoknots.hpp"
 
 // US letter
@@ -307,14 +308,14 @@ protected:
 
     virtual double get_scaling_ratio() const;
 
-    std::vector<point> get_residues_positions(rna_tree &rna) const;
+    std::vector<point> get_residues_positions(const rna_tree_snapshot &rna) const;
 
     /**
      * Obtain base-pair lines
      * @param rna
      * @return
      */
-    std::vector<std::pair<point, point>> get_lines(rna_tree &rna) const;
+    std::vector<std::pair<point, point>> get_lines(const rna_tree_snapshot &rna) const;
 
 private:
     void validate_stream() const;
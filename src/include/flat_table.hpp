@@ -0,0 +1,218 @@
+#ifndef TRAVELER_FLAT_TABLE_HPP
+#define TRAVELER_FLAT_TABLE_HPP
+
+#include <vector>
+#include <cstddef>
+#include <utility>
+
+/**
+ * non-owning row-major 2D view over contiguous memory
+ */
+template <typename value_type>
+class flat_table_view
+{
+public:
+    flat_table_view() = default;
+    flat_table_view(
+                    value_type* _data,
+                    size_t _rows,
+                    size_t _cols)
+    : ptr(_data), m(_rows), n(_cols)
+    { }
+
+public:
+    inline size_t rows() const
+    {
+        return m;
+    }
+    inline size_t cols() const
+    {
+        return n;
+    }
+    inline value_type* row(
+                           size_t i)
+    {
+        return ptr + i * n;
+    }
+    inline const value_type* row(
+                                 size_t i) const
+    {
+        return ptr + i * n;
+    }
+    inline value_type& operator()(
+                                  size_t i,
+                                  size_t j)
+    {
+        return ptr[i * n + j];
+    }
+    inline const value_type& operator()(
+                                        size_t i,
+                                        size_t j) const
+    {
+        return ptr[i * n + j];
+    }
+    inline value_type* data()
+    {
+        return ptr;
+    }
+
+private:
+    value_type* ptr = nullptr;
+    size_t m = 0;
+    size_t n = 0;
+};
+
+/**
+ * row-major 2D table stored in one contiguous block
+ */
+template <typename value_type>
+class flat_table
+{
+public:
+    flat_table() = default;
+    flat_table(
+               size_t _rows,
+               size_t _cols,
+               const value_type& value = value_type())
+    {
+        resize(_rows, _cols, value);
+    }
+
+public:
+    /**
+     * resize table and set all cells to `value`
+     */
+    void resize(
+                size_t _rows,
+                size_t _cols,
+                const value_type& value = value_type())
+    {
+        m = _rows;
+        n = _cols;
+        values.assign(m * n, value);
+    }
+    /**
+     * release memory
+     */
+    void clear()
+    {
+        m = n = 0;
+        std::vector<value_type>().swap(values);
+    }
+    void swap(
+              flat_table<value_type>& other)
+    {
+        values.swap(other.values);
+        std::swap(m, other.m);
+        std::swap(n, other.n);
+    }
+
+    inline size_t rows() const
+    {
+        return m;
+    }
+    inline size_t cols() const
+    {
+        return n;
+    }
+    inline bool empty() const
+    {
+        return values.empty();
+    }
+    inline value_type* row(
+                           size_t i)
+    {
+        return values.data() + i * n;
+    }
+    inline const value_type* row(
+                                 size_t i) const
+    {
+        return values.data() + i * n;
+    }
+    /**
+     * row `i`, so that cells can be accessed also as table[i][j]
+     */
+    inline value_type* operator[](
+                                  size_t i)
+    {
+        return row(i);
+    }
+    inline const value_type* operator[](
+                                        size_t i) const
+    {
+        return row(i);
+    }
+    inline value_type& operator()(
+                                  size_t i,
+                                  size_t j)
+    {
+        return values[i * n + j];
+    }
+    inline const value_type& operator()(
+                                        size_t i,
+                                        size_t j) const
+    {
+        return values[i * n + j];
+    }
+    inline value_type* data()
+    {
+        return values.data();
+    }
+    inline const value_type* data() const
+    {
+        return values.data();
+    }
+
+    bool operator==(
+                    const flat_table<value_type>& other) const
+    {
+        return m == other.m && n == other.n && values == other.values;
+    }
+
+private:
+    std::vector<value_type> values;
+    size_t m = 0;
+    size_t n = 0;
+};
+
+/**
+ * growable buffer handing out 2D views; memory is allocated only
+ * when a bigger view than ever before is requested
+ */
+template <typename value_type>
+class flat_table_buffer
+{
+public:
+    /**
+     * reserve space for `_rows` x `_cols` table
+     */
+    void reserve(
+                 size_t _rows,
+                 size_t _cols)
+    {
+        if (values.size() < _rows * _cols)
+            values.resize(_rows * _cols);
+    }
+    /**
+     * returns view of `_rows` x `_cols` table, previous content is lost
+     */
+    flat_table_view<value_type> view(
+                                     size_t _rows,
+                                     size_t _cols)
+    {
+        reserve(_rows, _cols);
+        return flat_table_view<value_type>(values.data(), _rows, _cols);
+    }
+    /**
+     * allocated size in bytes
+     */
+    size_t capacity_bytes() const
+    {
+        return values.size() * sizeof(value_type);
+    }
+
+private:
+    std::vector<value_type> values;
+};
+
+#endif /* !TRAVELER_FLAT_TABLE_HPP */
@@ -22,10 +22,35 @@
 #ifndef GTED_HPP
 #define GTED_HPP
 
+#include <cstdint>
+
 #include "strategy.hpp"
 #include "gted_tree.hpp"
+#include "flat_table.hpp"
+#include "task_pool.hpp"
+#include "ted_costs.hpp"
+#include "helix_tree.hpp"
 
 class mapping;
+class mapping_writer;
+
+/**
+ * keyroot subproblems with less cells (|subtree1| * |subtree2|)
+ * are not worth scheduling as separate tasks
+ */
+#define GTED_PARALLEL_MIN_CELLS 4096
+
+/**
+ * with more threads, forest tables with at least this many cells
+ * are computed by anti-diagonals split into chunks
+ */
+#define GTED_WAVEFRONT_MIN_CELLS    (1 << 20)
+#define GTED_WAVEFRONT_CHUNK        1024
+
+/**
+ * max_distance value meaning distance is not bounded
+ */
+#define GTED_NO_MAX_DISTANCE    ((size_t)-1)
 
 class gted
 {
@@ -36,101 +61,287 @@ public:
     typedef typename tree_type::sibling_iterator        sibling_iterator;
     typedef typename tree_type::reverse_post_order_iterator
     rev_post_order_iterator;
-    typedef std::vector<std::vector<size_t>>            tree_distance_table_type;
-    typedef std::vector<std::vector<size_t>>            forest_distance_table_type;
+    typedef uint32_t                                    distance_type;
+    typedef flat_table<distance_type>                   tree_distance_table_type;
+    typedef flat_table_view<distance_type>              forest_distance_table_type;
     
     /**
      * instead of using constants, use this functions
      * for costs of insert/delete/update
+     *
+     * default costs, inlined into init_costs; ted_costs
+     * and helix_costs have the same interface and are used if set
      */
     struct costs
     {
         static size_t del(iterator it);
         static size_t ins(iterator it);
         static size_t upd(iterator it1, iterator it2);
+        /**
+         * nodes of the same class have the same update costs,
+         * returns value < classes()
+         */
+        static size_t node_class(iterator it);
+        static size_t classes();
     };
     
 public:
     gted(
          const rna_tree& _t1,
          const rna_tree& _t2);
+    /**
+     * use precomputed `_t2`, it may be shared by more gted instances
+     * (also in more threads), e.g. when one target is compared
+     * with more templates
+     */
+    gted(
+         const rna_tree& _t1,
+         std::shared_ptr<tree_type> _t2);
+    
+    /**
+     * use `_costs` instead of default costs, nullptr resets them;
+     * has to be set before run and distance_lower_bound
+     */
+    void set_costs(
+                   std::shared_ptr<const ted_costs> _costs);
+    /**
+     * use stem-aware costs, both trees have to be helix_tree-s
+     */
+    void set_costs(
+                   std::shared_ptr<const helix_costs> _costs);
     
     /**
      * run gted
+     *
+     * independent keyroot subproblems are computed in `threads` threads;
+     * strategy table is not copied, it is used only during run
      */
     void run(
-             const strategy_table_type& _str);
+             const strategy_table_type& _str,
+             size_t threads = 1);
+    /**
+     * run gted after target changed only in one subtree
+     *
+     * `previous` ran on the same t1 and costs (without max distance),
+     * its target differs from t2 only in subtree `previous_root`,
+     * which is replaced by subtree `root` of t2 (postorder ids);
+     * only tdist of changed subtree and of its ancestors is computed,
+     * the rest is taken from `previous`
+     */
+    void run_incremental(
+                         const strategy_table_type& _str,
+                         const gted& previous,
+                         size_t previous_root,
+                         size_t root,
+                         size_t threads = 1);
     
     /**
      * compute mapping between trees
+     *
+     * with max_distance set, distance has to be at most max_distance;
+     * pairs are also streamed to `writer` as they are backtracked,
+     * the caller finishes the stream
+     */
+    mapping get_mapping(
+                        mapping_writer* writer = nullptr);
+    
+    /**
+     * prune forest cells whose distance is surely bigger than `k`,
+     * i.e. cells of forests which differ in size too much
+     *
+     * distances up to `k` stay exact, bigger ones are only known
+     * to be bigger than `k`
+     */
+    void set_max_distance(
+                          size_t k);
+    
+    /**
+     * cheap lower bound of distance between trees: maximum of size
+     * difference, node class histogram difference and bracket
+     * string distance, each multiplied by the cheapest operation
+     *
+     * bounds bigger than `limit` need not be exact,
+     * it is only guaranteed they are bigger than `limit`
      */
-    mapping get_mapping();
+    size_t distance_lower_bound(
+                                size_t limit = GTED_NO_MAX_DISTANCE);
+    
+    /**
+     * distance between whole trees, valid after run
+     */
+    distance_type get_distance() const;
     
 private:
+    /**
+     * scratch memory of LR kernel, sized once
+     * for the biggest (root) subproblem and reused
+     */
+    struct workspace
+    {
+        flat_table_buffer<distance_type> fbuffer;
+        // per column of forest table:
+        std::vector<size_t> lld;            // column of leftmost leaf - 1
+        std::vector<size_t> tdist_offset;   // offset of node in tdist
+        std::vector<size_t> upd_offset;     // offset of node class in upd_costs
+        std::vector<distance_type> ins;     // insert cost
+        // per row of forest table, used by wavefront kernel:
+        std::vector<size_t> row_lld;
+        std::vector<size_t> row_tdist_offset;
+        std::vector<size_t> row_upd_offset;
+        std::vector<distance_type> row_del;
+        std::vector<size_t> tree_rows;
+        std::vector<distance_type> ins_reversed;
+        std::vector<distance_type> diagonals[3];
+        
+        /**
+         * node of the other tree in heavy path function
+         */
+        struct heavy_node
+        {
+            size_t other;           // index in the other preorder
+            size_t size;            // subtree size
+            size_t tdist_offset;
+            size_t upd_offset;
+            distance_type ins;
+        };
+        // nodes by local preorder/mirrored preorder index
+        std::vector<heavy_node> by_pre, by_rpre;
+        // distance layers indexed by forests (pl, pr) of the other tree
+        flat_table_buffer<distance_type> empty_layer, tree_layer, forest_layer;
+        flat_table_buffer<distance_type> stage;
+    };
+    
+    /**
+     * scratch memory of calling thread
+     */
+    workspace& get_workspace();
+    
+private:
+    /**
+     * compute tdist of prepared trees and tables
+     */
+    void compute(
+                 size_t threads);
     /**
      * recursive compute distances between subtrees root1/root2
      *
      * recursive call on decomponed tree's subtrees
      */
     void compute_distance_recursive(
-                                    iterator root1,
-                                    iterator root2);
+                                    size_t root1,
+                                    size_t root2);
     /**
      * compute distances on each node root-leaf path
-     * with respect to actual strategy
+     * with respect to strategy `str`
      */
     void single_path_function(
-                              iterator root1,
-                              iterator root2);
+                              size_t root1,
+                              size_t root2,
+                              strategy str);
     /**
      * compute_distance between all nodes on root-leaf tree paths
+     *
+     * returned table is a view into calling thread's workspace,
+     * it is valid until next call
      */
-    std::vector<std::vector<size_t>> compute_distance(
-                                                      iterator root1,
-                                                      iterator root2);
+    forest_distance_table_type compute_distance(
+                                                size_t root1,
+                                                size_t root2,
+                                                strategy str);
     /**
      * only left/right paths
+     *
+     * rows of returned table are nodes of t1 (t2 if `swapped`)
+     * in left/right ordering, row 0 is the empty forest
+     */
+    forest_distance_table_type compute_distance_LR(
+                                                   size_t root1,
+                                                   size_t root2,
+                                                   bool right,
+                                                   bool swapped);
+    /**
+     * compute prepared forest table by anti-diagonals (wavefront),
+     * row 0 is filled yet
      */
-    template <typename iterator_type, typename funct_get_begin>
-    std::vector<std::vector<size_t>> compute_distance_LR(
-                                                         iterator root1,
-                                                         iterator root2,
-                                                         tree_type& t1,
-                                                         tree_type& t2,
-                                                         funct_get_begin get_begin);
-    
-private: // functions allowing some checks..
-    inline size_t get_tdist(
-                            iterator it1,
-                            iterator it2);
-    
-    inline void set_tdist(
-                          iterator it1,
-                          iterator it2,
-                          size_t value);
-    
-    inline size_t get_fdist(
-                            const forest_distance_table_type& fdist,
-                            const iterator& it1,
-                            const iterator& it2,
-                            size_t id1,
-                            size_t id2);
-    
-    inline void set_fdist(
-                          forest_distance_table_type& fdist,
-                          const iterator& it1,
-                          const iterator& it2,
-                          size_t value,
-                          size_t id1,
-                          size_t id2);
+    void compute_distance_wavefront(
+                                    forest_distance_table_type& fdist,
+                                    workspace& ws);
+    /**
+     * heavy path single-path function (Demaine et al.)
+     *
+     * computes tdist between all nodes on heavy path of root1 (root2
+     * if `swapped`) and all nodes of the second subtree
+     */
+    void compute_distance_heavy(
+                                size_t root1,
+                                size_t root2,
+                                bool swapped);
     
+private:
     inline void check_ids_postorder();
     
+    /**
+     * precompute costs of all nodes
+     */
+    void init_costs();
+    /**
+     * precompute costs using `model`, classes of the model
+     * are renumbered to classes present in the trees
+     */
+    template <typename cost_model>
+    void init_costs(
+                    const cost_model& model);
+    
+    /**
+     * checks that worst-case distance fits into distance_type
+     */
+    void check_distance_bound();
+    
+    /**
+     * set band of forest cells computed with max_distance
+     */
+    void init_band();
+    
+    /**
+     * memory of tdist and all workspaces in bytes; buffers never
+     * shrink, so after run it is the peak memory
+     */
+    size_t table_memory() const;
+    
 private:
-    tree_type t1, t2;
-    strategy_table_type STR;
-    strategy actual_str;
+    std::shared_ptr<tree_type> tree1, tree2;
+    tree_type& t1;
+    tree_type& t2;
+    const strategy_table_type* STR = nullptr;
     tree_distance_table_type tdist;
+    // one workspace per thread
+    std::vector<workspace> workspaces;
+    std::unique_ptr<task_pool> pool;
+    
+    std::shared_ptr<const ted_costs> custom_costs;
+    std::shared_ptr<const helix_costs> stem_costs;
+    // costs indexed by postorder ids
+    std::vector<distance_type> del1, ins2;
+    std::vector<uint8_t> class1, class2;
+    // number of node classes present in trees
+    size_t classes = 0;
+    // update costs [class1 * classes + class2]
+    std::vector<distance_type> upd_costs;
+    
+    // workspaces[0] contains left T1 forest table of roots
+    bool root_table_valid = false;
+    // t2 nodes whose tdist incremental run computes, empty otherwise
+    std::vector<bool> changed;
+    
+    size_t max_distance = GTED_NO_MAX_DISTANCE;
+    // cells (r, c) with |r - c| > band are set to band_cap
+    size_t band = GTED_NO_MAX_DISTANCE;
+    distance_type band_cap = 0;
+    
+#ifdef TESTS
+public:
+#endif
+    size_t wavefront_min_cells = GTED_WAVEFRONT_MIN_CELLS;
 };
 
 #endif /* !GTED_HPP */
@@ -24,19 +24,48 @@
 
 #include "rna_tree.hpp"
 
+/**
+ * parent id of the root node
+ */
+#define GTED_TREE_NO_PARENT     ((size_t)-1)
+
 /**
  * precompute and store some frequently needed values in gted
+ *
+ * all values are indexed by postorder ids of nodes, so gted
+ * does not need to touch tree iterators in the inner loops
  */
 struct gted_tree : public rna_tree
 {
 public:
     struct LRH
     {
-        iterator left, right, heavy;
+        size_t left, right, heavy;
     };
     struct LRH_table
     {
-        std::vector<iterator> left, right, heavy;
+        std::vector<size_t> left, right, heavy;
+    };
+    /**
+     * postorder numbering of the tree (left) or of its mirror image (right)
+     *
+     * subtree rooted at index `i` occupies indexes `lld[i]` .. `i`
+     */
+    struct ordering
+    {
+        std::vector<size_t> ids;    // index -> postorder id
+        std::vector<size_t> index;  // postorder id -> index
+        std::vector<size_t> lld;    // index -> index of leftmost leaf
+    };
+    /**
+     * preorder numbering of the tree (left) or of its mirror image (right)
+     *
+     * subtree rooted at index `i` occupies indexes `i` .. `i + size - 1`
+     */
+    struct preordering
+    {
+        std::vector<size_t> ids;    // index -> postorder id
+        std::vector<size_t> index;  // postorder id -> index
     };
     
 public:
@@ -66,89 +95,118 @@ public:
     }
 public:
     /**
-     * returns `it`s heavy child
+     * returns node with postorder id `id`
      */
-    inline iterator get_heavy_child(
-                                    const iterator& it) const
+    inline iterator get_node(
+                             size_t id) const
     {
-        check_same_tree(it);
-        return heavy_children[id(it)];
+        return nodes[id];
     }
     
     /**
-     * returns `it`s subtree size
+     * returns id of `id`s parent, GTED_TREE_NO_PARENT for root
+     */
+    inline size_t get_parent(
+                             size_t id) const
+    {
+        return parents[id];
+    }
+    
+    /**
+     * returns `id`s heavy child
+     */
+    inline size_t get_heavy_child(
+                                  size_t id) const
+    {
+        return heavy_children[id];
+    }
+    
+    /**
+     * returns `id`s subtree size
      */
     inline size_t get_size(
-                           const iterator& it) const
+                           size_t id) const
+    {
+        return sizes[id];
+    }
+    
+    /**
+     * returns if node `id` is paired
+     */
+    inline bool is_paired_node(
+                               size_t id) const
     {
-        check_same_tree(it);
-        return sizes[id(it)];
+        return paired[id];
     }
     
     /**
-     * returns `it`s leafs (left/right/heavy)
+     * returns if node `id` is root of tree
      */
-    inline LRH get_leafs(
-                         const iterator& it) const
+    inline bool is_root_node(
+                             size_t id) const
     {
-        check_same_tree(it);
-        return leafs[id(it)];
+        return roots[id];
     }
     
     /**
-     * returns `it`s keyroots
+     * returns `id`s leafs (left/right/heavy)
      */
-    inline LRH_table get_keyroots(
-                                  const iterator& it) const
+    inline const LRH& get_leafs(
+                                size_t id) const
     {
-        check_same_tree(it);
-        return keyroots[id(it)];
+        return leafs[id];
     }
     
     /**
-     * returns `it`s subforests
+     * returns `id`s keyroots
      */
-    inline LRH_table get_subforests(
-                                    const iterator& it) const
+    inline const LRH_table& get_keyroots(
+                                         size_t id) const
     {
-        check_same_tree(it);
-        return subforests[id(it)];
+        return keyroots[id];
     }
     
     /**
-     * returns if `it` is left child
+     * returns `id`s subforests
      */
-    inline bool is_left(
-                        iterator it) const
+    inline const LRH_table& get_subforests(
+                                           size_t id) const
     {
-        return is_first_child(it);
+        return subforests[id];
     }
     
     /**
-     * returns if `it` is right child
+     * returns left (postorder) or right (mirrored postorder) ordering
      */
-    inline bool is_right(
-                         iterator it) const
+    inline const ordering& get_ordering(
+                                        bool right) const
     {
-        return is_last_child(it);
+        return right ? right_ordering : left_ordering;
     }
     
     /**
-     * returns if `it` is heavy child
+     * returns left (preorder) or right (mirrored preorder) preordering
      */
-    inline bool is_heavy(
-                         iterator it) const
+    inline const preordering& get_preordering(
+                                              bool right) const
     {
-        return is_root(it) ||
-        get_heavy_child(parent(it)) == it;
+        return right ? right_preordering : left_preordering;
     }
     
 private:
-    std::vector<iterator> heavy_children;
+    std::vector<iterator> nodes;
+    std::vector<size_t> parents;
+    std::vector<size_t> heavy_children;
     std::vector<size_t> sizes;
+    std::vector<bool> paired;
+    std::vector<bool> roots;
     std::vector<LRH> leafs;
     std::vector<LRH_table> keyroots;
     std::vector<LRH_table> subforests;
+    ordering left_ordering;
+    ordering right_ordering;
+    preordering left_preordering;
+    preordering right_preordering;
 };
 
 #endif /* !GTED_TREE_HPP */
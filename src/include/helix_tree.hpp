@@ -0,0 +1,120 @@
+#ifndef TRAVELER_HELIX_TREE_HPP
+#define TRAVELER_HELIX_TREE_HPP
+
+#include <vector>
+
+#include "rna_tree.hpp"
+#include "mapping.hpp"
+
+/**
+ * longer helices (loop segments) are split into more nodes,
+ * so that helix_costs classes fit into gted's class tables
+ */
+#define HELIX_TREE_MAX_NODES    127
+
+/**
+ * rna_tree with every helix (maximal run of stacked base pairs, i.e. pairs
+ * whose only child is a pair) compressed into one node labeled by its
+ * outermost pair; optionally also every run of consecutive unpaired
+ * siblings is compressed into one node labeled by its first base
+ *
+ * node of compressed tree knows the number of nodes it stands for
+ * (rna_pair_label::get_compressed_nodes), postorder ids of the original
+ * nodes are available by get_nodes
+ */
+class helix_tree
+{
+public:
+    typedef rna_tree::iterator iterator;
+
+public:
+    helix_tree(
+               rna_tree rna,
+               bool compress_loops = false);
+
+public:
+    inline const rna_tree& get_tree() const
+    {
+        return tree;
+    }
+    /**
+     * postorder ids of original nodes represented by compressed node `id`,
+     * outermost pair or leftmost base first
+     */
+    inline const std::vector<size_t>& get_nodes(
+                                                size_t id) const
+    {
+        return nodes[id];
+    }
+
+    /**
+     * expand mapping of compressed trees to mapping of original trees;
+     * in matched helices pairs are matched from the outermost one,
+     * remaining inner pairs of the longer helix are deleted/inserted,
+     * loop segments are matched from the left in the same way;
+     * distance and pair costs count deleted/inserted original nodes
+     */
+    static mapping expand(
+                          const mapping& map,
+                          const helix_tree& t1,
+                          const helix_tree& t2);
+
+private:
+    /**
+     * append children of original node `parent` to brackets of compressed tree
+     */
+    static void compress(
+                         iterator parent,
+                         bool compress_loops,
+                         std::string& brackets,
+                         std::vector<iterator>& sources,
+                         std::vector<std::vector<size_t>>& groups);
+
+private:
+    rna_tree tree;
+    // compressed postorder id -> original postorder ids
+    std::vector<std::vector<size_t>> nodes;
+};
+
+/**
+ * stem-aware costs for helix_tree: deleting/inserting a whole helix
+ * costs less than deleting/inserting its pairs one by one, so gted
+ * rather keeps helices together than splitting them
+ *
+ * helix of n pairs costs `helix + (n - 1) * stacked`, changing its
+ * length by k costs the same as a helix of k pairs; loop segment of
+ * n bases costs `n * single`, changing its length by k `k * single`;
+ * updates of root to non-root and of pair to unpaired base cost `root`
+ *
+ * same interface as gted::costs
+ */
+class helix_costs
+{
+public:
+    typedef rna_tree::iterator iterator;
+
+public:
+    size_t del(iterator it) const;
+    size_t ins(iterator it) const;
+    size_t upd(iterator it1, iterator it2) const;
+    /**
+     * nodes of the same class have the same costs,
+     * returns value < classes()
+     */
+    size_t node_class(iterator it) const;
+    static size_t classes();
+
+public:
+    size_t single = 2;      // unpaired base
+    size_t helix = 2;       // helix with its first pair
+    size_t stacked = 1;     // each other pair of helix
+    size_t root = 10000;
+
+private:
+    size_t remove(
+                  iterator it) const;
+    size_t helix_cost(
+                      size_t pairs) const;
+};
+
+#endif /* !TRAVELER_HELIX_TREE_HPP */
@@ -0,0 +1,126 @@
+#ifndef TRAVELER_LABEL_TEXT_HPP
+#define TRAVELER_LABEL_TEXT_HPP
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <ostream>
+
+#define LABEL_TEXT_CAPACITY     15
+
+/**
+ * short text of a base (nucleotide, 5'/3' mark, pseudoknot key)
+ * stored inline, without heap allocation; longer text is rejected
+ */
+class label_text
+{
+public:
+    label_text()
+    {
+        text[0] = '\0';
+    }
+    label_text(
+               const char* s)
+    {
+        assign(s, strlen(s));
+    }
+    label_text(
+               const std::string& s)
+    {
+        assign(s.data(), s.size());
+    }
+
+public:
+    inline bool operator==(
+                           const label_text& other) const
+    {
+        return length == other.length && memcmp(text, other.text, length) == 0;
+    }
+    inline bool operator!=(
+                           const label_text& other) const
+    {
+        return !(*this == other);
+    }
+    inline char operator[](
+                           size_t i) const
+    {
+        return text[i];
+    }
+    inline bool empty() const
+    {
+        return length == 0;
+    }
+    inline size_t size() const
+    {
+        return length;
+    }
+    inline const char* c_str() const
+    {
+        return text;
+    }
+    inline std::string str() const
+    {
+        return std::string(text, length);
+    }
+
+    friend std::ostream& operator<<(
+                                    std::ostream& out,
+                                    const label_text& label)
+    {
+        return out.write(label.text, label.length);
+    }
+
+private:
+    void assign(
+                const char* s,
+                size_t n);
+
+private:
+    char text[LABEL_TEXT_CAPACITY];
+    uint8_t length = 0;
+};
+
+/**
+ * handle of text in a process-wide pool of distinct strings,
+ * for texts that are long or repeat across nodes (numbering labels);
+ * equal texts have equal handles, the empty one is 0
+ */
+class interned_string
+{
+public:
+    interned_string() = default;
+    interned_string(
+                    const std::string& s);
+
+public:
+    inline bool operator==(
+                           const interned_string& other) const
+    {
+        return index == other.index;
+    }
+    inline bool operator!=(
+                           const interned_string& other) const
+    {
+        return index != other.index;
+    }
+    inline bool empty() const
+    {
+        return index == 0;
+    }
+    /**
+     * the text, valid until the end of the process
+     */
+    const std::string& str() const;
+
+    friend std::ostream& operator<<(
+                                    std::ostream& out,
+                                    const interned_string& s)
+    {
+        return out << s.str();
+    }
+
+private:
+    uint32_t index = 0;
+};
+
+#endif /* !TRAVELER_LABEL_TEXT_HPP */
@@ -24,8 +24,13 @@
 
 #include <vector>
 #include <map>
+#include <string>
+#include <fstream>
 #include <cstddef> // size_t
 
+#define MAPPING_NDJSON_FORMAT   "traveler-mapping"
+#define MAPPING_NDJSON_VERSION  1
+
 /**
  * representation for mapping between two trees
  */
@@ -34,10 +39,32 @@ class mapping
 public:
     typedef std::vector<size_t> indexes;
     
+    enum operation
+    {
+        insert,
+        remove,
+        update,
+    };
+    
     struct mapping_pair
     {
+        mapping_pair() = default;
+        mapping_pair(
+                     size_t from,
+                     size_t to,
+                     size_t cost = 0)
+        : from(from), to(to), cost(cost)
+        { }
+        
         // "from" represents template an "to" represents target
         size_t from, to;
+        // cost of the edit operation in cost model of TED
+        size_t cost = 0;
+        
+        inline operation type() const
+        {
+            return from == 0 ? insert : to == 0 ? remove : update;
+        }
         
         bool operator<(
                        const mapping_pair& other) const;
@@ -66,4 +93,37 @@ public:
     std::vector<mapping_pair> map;
 };
 
+/**
+ * incremental writer of mapping in NDJSON format, one object per line:
+ *      {"format":"traveler-mapping","version":1}
+ *      {"op":"update","from":1,"to":1,"cost":0}
+ *      ...
+ *      {"distance":4}
+ * pairs come in any order, e.g. as TED backtracks them; ids are
+ * postorder ids + 1 and 0 is no node, as in mapping; distance is
+ * the sum of costs of all pairs
+ */
+class mapping_writer
+{
+public:
+    mapping_writer(
+                   const std::string& filename);
+    
+public:
+    void write(
+               const mapping::mapping_pair& pair);
+    /**
+     * write closing distance line, throws io_exception if any write failed
+     */
+    void finish();
+    
+    static const char* operation_name(
+                                      mapping::operation op);
+    
+private:
+    std::string filename;
+    std::ofstream out;
+    size_t distance = 0;
+};
+
 #endif /* !MAPPING_HPP */
@@ -26,6 +26,7 @@
 #include "point.hpp"
 #include "rna_tree.hpp"
 #include "compact.hpp"
+#include "rna_tree_snapshot.hpp"
 
 class overlap_checks
 {
@@ -75,7 +76,7 @@ private:
      *          => going pre_post_order in tree
      */
     edges get_edges(
-                    rna_tree& rna);
+                    const rna_tree_snapshot& rna);
 
     /**
      * run checks for edges
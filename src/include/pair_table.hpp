@@ -0,0 +1,76 @@
+#ifndef TRAVELER_PAIR_TABLE_HPP
+#define TRAVELER_PAIR_TABLE_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * pairs of opening and closing brackets, "()" form the tree, all other
+ * types are pseudoknots of any order
+ */
+#define PAIR_TABLE_BRACKETS     "()[]{}<>AaBbCcDdEeFfGgHhIiJjKkLlMmNnOoPpQqRrSsTtUuVvWwXxYyZz"
+#define PAIR_TABLE_UNPAIRED     ((uint32_t)-1)
+
+/**
+ * pair table of dot-bracket structure
+ *
+ * parsed in one pass with a stack for every bracket type, the stacks are
+ * threaded through the table itself, so parsing allocates just the table
+ */
+class pair_table
+{
+public:
+    struct entry
+    {
+        uint32_t partner = PAIR_TABLE_UNPAIRED;
+        // nesting depth among brackets of the same type
+        uint32_t level = 0;
+        // index of bracket pair in PAIR_TABLE_BRACKETS, 0 is "()"
+        uint8_t type = 0;
+    };
+
+public:
+    /**
+     * parse `brackets`, throws wrong_argument_exception on unknown
+     * character or unbalanced bracket
+     */
+    pair_table(
+               const std::string& brackets);
+
+public:
+    inline size_t size() const
+    {
+        return entries.size();
+    }
+    inline const entry& operator[](
+                                   size_t i) const
+    {
+        return entries[i];
+    }
+    inline bool paired(
+                       size_t i) const
+    {
+        return entries[i].partner != PAIR_TABLE_UNPAIRED;
+    }
+    inline bool opening(
+                        size_t i) const
+    {
+        return paired(i) && i < entries[i].partner;
+    }
+    inline bool pseudoknot(
+                           size_t i) const
+    {
+        return paired(i) && entries[i].type != 0;
+    }
+    /**
+     * opening bracket of type `type`
+     */
+    static char bracket(
+                        size_t type);
+
+private:
+    std::vector<entry> entries;
+};
+
+#endif /* !TRAVELER_PAIR_TABLE_HPP */
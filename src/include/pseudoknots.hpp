@@ -3,6 +3,7 @@
 
 #include <vector>
 #include "rna_tree.hpp"
+#include "rna_tree_snapshot.hpp"
 #include "geometry.hpp"
 
 typedef std::pair<point, point> line;
@@ -30,7 +31,7 @@ private:
     std::vector<pseudoknot_segment> segments;
     double font_size;
 
-    void find_pseudoknot_segments(rna_tree::pre_post_order_iterator begin, rna_tree::pre_post_order_iterator end);
+    void find_pseudoknot_segments(rna_tree &rna);
 
 public:
 
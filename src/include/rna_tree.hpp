@@ -56,6 +56,14 @@ public:
              const std::string& _labels,
              const std::vector<point>& _points,
              const std::string& _name = "");
+    /**
+     * build RNA from already parsed structure
+     */
+    rna_tree(
+             const pair_table& _pairs,
+             const std::string& _constraints,
+             const std::string& _labels,
+             const std::string& _name = "");
     
     /**
      * update postorder points
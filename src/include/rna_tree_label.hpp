@@ -23,26 +23,31 @@
 #define RNA_TREE_LABEL_HPP
 
 #include <vector>
+#include <array>
+#include <cstdint>
 
 #include "tree_base_node.hpp"
+#include "label_text.hpp"
 #include "point.hpp"
 #include "rectangle.hpp"
 
 /**
  * object representing one base
+ *
+ * all fields are stored inline, so copying a label does not allocate
  */
 struct rna_label
 {
     bool operator==(
                     const rna_label& other) const;
     
-    std::string label = "";
-    std::string tmp_label = ""; //label used in the template (can be used to store information about the mapped nodes label in the template)
+    label_text label;
+    label_text tmp_label; //label used in the template (can be used to store information about the mapped nodes label in the template)
     int tmp_ix = -1; //position in template
-    std::string tmp_numbering_label = ""; //is of type string because index can be 21a when provided by the user
+    interned_string tmp_numbering_label; //is of type string because index can be 21a when provided by the user
     point p = point::bad_point();
     int seq_ix = -1; //sequential index of the label. Corresponds to the position of the label as assigned by the pre_post_order iterator
-    std::string pseudoknot = "";
+    label_text pseudoknot;
 };
 
 /**
@@ -129,24 +134,38 @@ public:
     void set_p(const point _p, const size_t index);
 
     void set_bounding_objects(std::vector<rectangle> bo) {
-        bounding_objects = bo;
+        has_bounding_object = false;
+        more_bounding_objects.clear();
+        add_bounding_objects(bo);
     }
 
     void set_bounding_objects(rectangle bo) {
-        bounding_objects.clear();
+        has_bounding_object = false;
+        more_bounding_objects.clear();
         add_bounding_objects(bo);
     }
 
     void add_bounding_objects(rectangle bo) {
-        bounding_objects.push_back(bo);
+        if (!has_bounding_object) {
+            bounding_object = bo;
+            has_bounding_object = true;
+        } else
+            more_bounding_objects.push_back(bo);
     }
 
     void add_bounding_objects(std::vector<rectangle> bos) {
-        bounding_objects.insert(bounding_objects.end(), bos.begin(), bos.end());
+        for (const rectangle& bo : bos)
+            add_bounding_objects(bo);
     }
 
     std::vector<rectangle> get_bounding_objects(){
-        return bounding_objects;
+        std::vector<rectangle> bos;
+        if (has_bounding_object) {
+            bos.reserve(1 + more_bounding_objects.size());
+            bos.push_back(bounding_object);
+            bos.insert(bos.end(), more_bounding_objects.begin(), more_bounding_objects.end());
+        }
+        return bos;
     }
 
     int get_node_ix_in_source(){
@@ -157,6 +176,14 @@ public:
         this->source_ix = source_ix;
     }
 
+    size_t get_compressed_nodes() const{
+        return compressed_nodes;
+    }
+
+    void set_compressed_nodes(size_t compressed_nodes){
+        this->compressed_nodes = compressed_nodes;
+    }
+
 
 
 public:
@@ -172,11 +199,16 @@ public:
     std::vector<size_t> remake_ids;
     
 private:
-    std::vector<rna_label> labels;
+    std::array<rna_label, 2> labels;
+    uint8_t labels_count = 0; //1 for single base, 2 for base pair
     bool de_novo_predicted = false; //information about whether a base-pair in the target was predicted de novo or copied over from template
+    bool has_bounding_object = false;
     point parent_center;
-    std::vector<rectangle> bounding_objects;
+    //first bounding object is kept inline, as leaves have just one
+    rectangle bounding_object;
+    std::vector<rectangle> more_bounding_objects;
     int source_ix = 0; //node index in the source tree (template)
+    size_t compressed_nodes = 1; //number of stacked base pairs or unpaired bases the node stands for (more than one only in helix_tree)
 
     
 };
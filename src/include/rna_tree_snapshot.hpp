@@ -0,0 +1,78 @@
+#ifndef TRAVELER_RNA_TREE_SNAPSHOT_HPP
+#define TRAVELER_RNA_TREE_SNAPSHOT_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "rna_tree.hpp"
+
+#define RNA_TREE_SNAPSHOT_NONE  ((size_t)-1)
+
+/**
+ * immutable structure-of-arrays copy of rna_tree for read-only passes
+ *
+ * nodes are indexed in preorder, residues (labels) in sequence order
+ * of pre_post_order_iterator, so residue 0 and the last one are 5' and 3'
+ * ends of the root; the snapshot is built once per stage and does not
+ * follow later changes of the tree
+ */
+class rna_tree_snapshot
+{
+public:
+    rna_tree_snapshot(
+                      rna_tree& rna);
+
+public:
+    inline size_t nodes() const
+    {
+        return parent.size();
+    }
+    inline size_t residues() const
+    {
+        return node.size();
+    }
+    inline bool leaf(
+                     size_t v) const
+    {
+        return first_child[v] == RNA_TREE_SNAPSHOT_NONE;
+    }
+    inline bool paired(
+                       size_t v) const
+    {
+        return partner[residue[v]] != RNA_TREE_SNAPSHOT_NONE;
+    }
+    inline point p(
+                   size_t r) const
+    {
+        return point(x[r], y[r]);
+    }
+    /**
+     * the same as rna_pair_label::initiated_points of node `v`
+     */
+    bool initiated(
+                   size_t v) const;
+    /**
+     * the same as rna_pair_label::center of node `v`
+     */
+    point center(
+                 size_t v) const;
+
+public:
+    // per node, RNA_TREE_SNAPSHOT_NONE if there is no such node
+    std::vector<size_t> parent;
+    std::vector<size_t> first_child;
+    std::vector<size_t> next_sibling;
+    std::vector<size_t> residue;        // first residue of node
+    std::vector<size_t> id;             // id of node in rna_tree
+    std::vector<uint8_t> status;        // rna_pair_label::status_type
+    // per residue
+    std::vector<double> x, y;
+    std::vector<char> label;            // first character, ' ' if label is empty
+    std::vector<size_t> partner;        // other residue of base pair or RNA_TREE_SNAPSHOT_NONE
+    std::vector<size_t> node;
+    std::vector<int> seq_ix;
+    std::vector<size_t> pseudoknot;     // residues in the same pseudoknot share the number, 0 is none
+};
+
+#endif /* !TRAVELER_RNA_TREE_SNAPSHOT_HPP */
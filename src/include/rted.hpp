@@ -25,6 +25,28 @@
 #include "strategy.hpp"
 #include "rna_tree.hpp"
 
+/**
+ * trees with less pairs of nodes always use uniform left/right strategy
+ */
+#define RTED_FIXED_MAX_CELLS    (1 << 16)
+/**
+ * uniform left/right strategy is used when it computes less than
+ * RTED_FIXED_MAX_RATIO * |T1| * |T2| cells; computing optimal
+ * strategy costs much more per pair of nodes than one cell
+ */
+#define RTED_FIXED_MAX_RATIO    100
+/**
+ * parallel run() splits T2 into one range of columns per thread
+ * and T1 into this many blocks of rows per range
+ */
+#define RTED_BLOCKS_PER_RANGE   16
+/**
+ * costs of T2 strategies are multiplied by this factor (in percent):
+ * gted computes paths in T2 with column-wise access to tree distances,
+ * so a subproblem of T2 path takes longer than one of T1 path
+ */
+#define RTED_T2_COST_FACTOR_PERCENT     150
+
 class rted
 {
 public:
@@ -34,6 +56,12 @@ public:
     typedef typename tree_type::sibling_iterator        sibling_iterator;
     
     typedef std::vector<size_t>                         table_type;
+    /**
+     * costs of strategies are stored in 32 bits, bigger costs saturate;
+     * that can only make strategy of huge trees suboptimal, never wrong
+     */
+    typedef uint32_t                                    cost_type;
+    typedef std::vector<cost_type>                      cost_table_type;
     
 public:
     rted(
@@ -41,8 +69,57 @@ public:
          const tree_type& _t2);
     /**
      * run computations
+     *
+     * with more `threads`, T2 is split into ranges of consecutive columns
+     * (in postorder) and T1 into blocks of consecutive rows; block of a range
+     * waits for the previous block of the same range and for the same block
+     * of previous ranges, so blocks are computed as an anti-diagonal wavefront.
+     * Every column still sees rows in postorder and every row columns
+     * in postorder, so STR does not depend on `threads`
+     */
+    void run(
+             size_t threads = 1);
+    
+    /**
+     * fill STR with uniform left or right (Zhang-Shasha) strategy,
+     * if it is cheap compared to computing optimal strategy by run():
+     * for small trees or when keyroot subtrees of both trees are small
+     *
+     * returns true if STR was filled and run() is not needed
+     */
+    bool select_fixed_strategy();
+    
+    /**
+     * strategy table of `t1` and `t2`: fixed one if select_fixed_strategy()
+     * picks it, optimal one computed by run() in `threads` threads otherwise
+     */
+    static strategy_table_type compute_strategies(
+                                                  const tree_type& t1,
+                                                  const tree_type& t2,
+                                                  size_t threads = 1);
+    
+private:
+    struct t2_hw_partial_result {
+        // for more details, see functions:
+        // update_T2_LRH_w_tables or update_T1_LRH_v_tables
+        cost_type subtree_size;
+        cost_type c_min;
+        cost_type H_value;
+    };
+    typedef std::vector<t2_hw_partial_result>
+    partial_result_arr;
+    
+    /**
+     * values of node it2 added to w tables of its parent
+     * by update_T2_LRH_w_tables()
      */
-    void run();
+    struct w_link
+    {
+        size_t c_min;
+        cost_type Lw;
+        cost_type Rw;
+        cost_type Hw;
+    };
     
 private:
     /**
@@ -116,14 +193,27 @@ private:
     
     /**
      * checks initialization for *LRH* tables
-     * and for parents of it-s too,
-     * if parents are not initalized, init parent
+     * and for parent of it1 too,
+     * if parent is not initalized, init parent
      *      -- visiting first_child(parent)
      */
     void first_visit(
                      iterator it1,
                      iterator it2);
     
+    /**
+     * init T1_{L,R,H}v[parent(it1)][it2] when visiting first child it1
+     */
+    void init_parent_v_tables(
+                              iterator it1,
+                              iterator it2);
+    
+    /**
+     * init T2_{L,R,H}w[parent(it2)] when visiting first child it2
+     */
+    void init_parent_w_tables(
+                              iterator it2);
+    
     /**
      * compute C from rted_opt_strategy(F,G) (== lines 7-12)
      * find minimum and stores minimal_path
@@ -167,10 +257,63 @@ private:
      *
      * How to predict we are on heavy_parent_path???
      *      ... See update_T1_LRH_v_tables()
+     *
+     * `link` holds c_min and T2_{L,R,H}w[it] computed by visiting it2
      */
     void update_T2_LRH_w_tables(
                                 iterator it2,
-                                size_t c_min);
+                                const w_link& link);
+    
+    /**
+     * compute cells of rows in `block` and columns in `range`
+     * (lines 4-22 of rted_opt_strategy(F,G));
+     * values of columns whose parent is in a later range are passed
+     * to that range through T2_links
+     */
+    void compute_block(
+                       size_t block,
+                       size_t range);
+    
+    /**
+     * split T1 to `blocks` blocks of rows and T2 to `ranges` ranges
+     * of columns, link columns whose parent is in another range
+     */
+    void split_tables(
+                      size_t blocks,
+                      size_t ranges);
+    
+    /**
+     * assign T1_{L,R,H}v and T1_Hv_partials rows to nodes
+     *
+     * row of node is needed from visiting its first child
+     * until all pairs (node, *) are computed, so only rows
+     * of current node and its ancestors are used at once;
+     * returns number of rows
+     */
+    size_t assign_T1_slots();
+    
+    /**
+     * set columns `first_id`..`last_id` of rows first used by pairs
+     * (it1, *) to RTED_BAD: row of leaf it1 and of its parent,
+     * if it1 is the first child
+     */
+    void init_T1_rows(
+                      iterator it1,
+                      size_t first_id,
+                      size_t last_id);
+    
+    /**
+     * set T2_{L,R,H}w and T2_Hw_partials of columns `first_id`..`last_id`
+     * to RTED_BAD, w tables of every it1 are sums over children of w
+     */
+    void init_T2_columns(
+                         size_t first_id,
+                         size_t last_id);
+    
+    /**
+     * peak memory of all tables in bytes
+     */
+    size_t peak_table_memory() const;
     
 private:
     void check_postorder();
@@ -201,35 +344,52 @@ private:
     
     // subtree sizes
     T1_Size,
-    T2_Size,
+    T2_Size;
+    
+    // nodes by postorder id
+    std::vector<iterator>
+    T1_nodes,
+    T2_nodes;
     
     //main loop, {LRH}w
+    cost_table_type
     T2_Lw,
     T2_Rw,
     T2_Hw;
     
-    // 2D tables: {LRH}v[v_id][w_id] == value
-    std::vector<table_type>
+    // 2D tables: {LRH}v(T1_slots[v_id], w_id) == value,
+    // only rows of nodes being computed are needed at once, so tables
+    // have fewer rows than T1 and rows are reused, see assign_T1_slots()
+    flat_table<cost_type>
     T1_Lv,
     T1_Rv,
     T1_Hv;
     
-    
-    struct t2_hw_partial_result {
-        // for more details, see functions:
-        // update_T2_LRH_w_tables or update_T1_LRH_v_tables
-        size_t subtree_size;
-        size_t c_min;
-        size_t H_value;
-    };
-    typedef std::vector<t2_hw_partial_result>
-    partial_result_arr;
+    // row of node in 2D tables
+    std::vector<size_t>
+    T1_slots;
     
     partial_result_arr
     T2_Hw_partials;
-    std::vector<partial_result_arr>
+    flat_table<t2_hw_partial_result>
     T1_Hv_partials;
     
+    // first row of blocks and first column of ranges, with end at back
+    table_type
+    T1_blocks,
+    T2_ranges;
+    
+    // index of column in T2_links tables if its parent is in other range,
+    // or RTED_NO_SLOT
+    table_type
+    T2_link_index;
+    // columns linked to range, in postorder
+    std::vector<table_type>
+    T2_range_links;
+    // T2_links[block](row in block, T2_link_index[w_id]), alive
+    // from first until last range of block is computed
+    std::vector<flat_table<w_link>>
+    T2_links;
 };
 
 #endif /* !RTED_HPP */
@@ -0,0 +1,33 @@
+#ifndef TRAVELER_SIMD_HPP
+#define TRAVELER_SIMD_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * vectorized helpers for distance kernels; implementation
+ * (AVX2, SSE4.1 or scalar) is selected at runtime by cpu features
+ */
+namespace simd
+{
+    /**
+     * out[i] = min(a[i] + b[i], c[i] + d[i], e[i]) for i < n
+     *
+     * sums must not overflow
+     */
+    void min3_add(
+                  const uint32_t* a,
+                  const uint32_t* b,
+                  const uint32_t* c,
+                  const uint32_t* d,
+                  const uint32_t* e,
+                  uint32_t* out,
+                  size_t n);
+
+    /**
+     * name of selected implementation
+     */
+    const char* implementation();
+}
+
+#endif /* !TRAVELER_SIMD_HPP */
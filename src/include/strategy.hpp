@@ -24,6 +24,9 @@
 
 #include <vector>
 #include <ostream>
+#include <cstdint>
+
+#include "flat_table.hpp"
 
 enum rted_strategy : char
 {
@@ -35,6 +38,10 @@ enum rted_strategy : char
     RTED_T2_HEAVY = 5,
 };
 
+/**
+ * strategy is one byte, so that |T1| * |T2| table stays small
+ */
+
 struct strategy
 {
     strategy() = default;
@@ -74,26 +81,18 @@ public:
                                     strategy str);
     
 private:
-    enum _strategy
-    {
-        left,
-        right,
-        heavy
-    };
-    enum _tree
-    {
-        T1,
-        T2
-    };
+    bool inited() const;
+    
+private:
+    static const uint8_t none = UINT8_MAX;
     
-    _strategy   str;
-    _tree       tree;
-    bool inited = false;
+    // rted_strategy value or none
+    uint8_t index = none;
 };
 
 
 // rted/gted type:
-typedef std::vector<std::vector<strategy>>  strategy_table_type;
+typedef flat_table<strategy>                strategy_table_type;
 
 std::ostream& operator<<(
                          std::ostream& out,
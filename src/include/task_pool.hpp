@@ -0,0 +1,130 @@
+#ifndef TRAVELER_TASK_POOL_HPP
+#define TRAVELER_TASK_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * work-stealing pool of threads
+ *
+ * every thread owns a deque of tasks, it runs its own tasks from the back
+ * and steals from the front of other deques. Thread waiting for a task_group
+ * runs pending tasks instead of blocking, so groups may be nested.
+ * Thread which created the pool has index 0 and works only while waiting.
+ */
+class task_pool
+{
+public:
+    typedef std::function<void()> task_type;
+
+    class task_group;
+
+public:
+    /**
+     * `threads` is total number of threads including the calling one;
+     * with one thread tasks are run directly in task_group::run
+     */
+    task_pool(
+              size_t threads);
+    ~task_pool();
+
+    task_pool(const task_pool&) = delete;
+    task_pool& operator=(const task_pool&) = delete;
+
+public:
+    /**
+     * number of threads including the creating one
+     */
+    inline size_t size() const
+    {
+        return queues.size();
+    }
+
+    /**
+     * index of calling thread in pool, 0 for threads not owned by pool
+     */
+    size_t thread_index() const;
+
+private:
+    struct entry
+    {
+        task_type task;
+        task_group* group;
+    };
+    struct queue
+    {
+        std::mutex lock;
+        std::deque<entry> tasks;
+    };
+
+    void push(
+              entry e);
+    /**
+     * run one task from own or stolen from other queue,
+     * returns false if there was none;
+     * if `only` is set, only its tasks are considered
+     */
+    bool run_one(
+                 size_t index,
+                 const task_group* only = nullptr);
+    void work(
+              size_t index);
+
+private:
+    std::vector<std::unique_ptr<queue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> queued;
+    std::mutex sleep_lock;
+    std::condition_variable sleep;
+    bool stop = false;
+};
+
+/**
+ * set of tasks waited for together
+ */
+class task_pool::task_group
+{
+public:
+    task_group(
+               task_pool& _pool);
+    /**
+     * waits for unfinished tasks, exceptions are dropped
+     */
+    ~task_group();
+
+    task_group(const task_group&) = delete;
+    task_group& operator=(const task_group&) = delete;
+
+public:
+    void run(
+             task_type task);
+
+    /**
+     * wait until all tasks are finished, meanwhile run pending tasks
+     * (only tasks of this group if not `run_others`);
+     * rethrows first exception thrown by a task
+     */
+    void wait(
+              bool run_others = true);
+
+private:
+    friend class task_pool;
+
+    void finished(
+                  std::exception_ptr e);
+
+private:
+    task_pool& pool;
+    std::atomic<size_t> pending;
+    std::mutex error_lock;
+    std::exception_ptr error;
+};
+
+#endif /* !TRAVELER_TASK_POOL_HPP */
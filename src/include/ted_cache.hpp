@@ -0,0 +1,69 @@
+#ifndef TRAVELER_TED_CACHE_HPP
+#define TRAVELER_TED_CACHE_HPP
+
+#include <string>
+
+#include "rna_tree.hpp"
+#include "mapping.hpp"
+
+class ted_costs;
+
+/**
+ * content-addressed directory of TED mappings
+ *
+ * key is the text of brackets and labels of both trees, of the cost model
+ * description and, with custom costs, of the cost classes of all nodes,
+ * so that changed structures or costs never hit an old mapping
+ *
+ * entry is stored in `directory`/HASH.json, HASH is a 64-bit hash of the key
+ * that just picks the file; entry holds the key itself, which is compared
+ * on load, so colliding keys are a miss and never a wrong mapping
+ */
+class ted_cache
+{
+public:
+    /**
+     * `directory` is created if it does not exist
+     */
+    ted_cache(
+              const std::string& directory);
+
+public:
+    /**
+     * key of mapping of `templated` to `matched`, computed with
+     * cost model described by `model`; nullptr `costs` are default ones
+     */
+    std::string get_key(
+                        rna_tree& templated,
+                        rna_tree& matched,
+                        const std::string& model,
+                        const ted_costs* costs) const;
+    /**
+     * cache file of entry with `key`
+     */
+    std::string get_file(
+                         const std::string& key) const;
+
+    /**
+     * load cached mapping with `key` to `map` and its TED distance
+     * to `distance`, returns false on miss
+     */
+    bool load(
+              const std::string& key,
+              mapping& map,
+              size_t& distance) const;
+    /**
+     * store `map` with TED distance `distance` under `key`; file appears
+     * atomically, so that concurrent runs sharing the directory never
+     * read a partial one
+     */
+    void save(
+              const std::string& key,
+              const mapping& map,
+              size_t distance) const;
+
+private:
+    std::string directory;
+};
+
+#endif /* !TRAVELER_TED_CACHE_HPP */
@@ -0,0 +1,110 @@
+#ifndef TRAVELER_TED_COSTS_HPP
+#define TRAVELER_TED_COSTS_HPP
+
+#include <iosfwd>
+#include <string>
+
+#include "rna_tree.hpp"
+
+/**
+ * number of nucleotide kinds distinguished by ted_costs: A, C, G, U (or T), other
+ */
+#define TED_COSTS_NUCLEOTIDES   5
+
+/**
+ * biggest cost accepted in configuration, so that sums
+ * of costs fit into gted::distance_type
+ */
+#define TED_COSTS_MAX_VALUE     (1 << 20)
+
+/**
+ * label aware costs of tree edit operations, configurable at runtime
+ *
+ * costs of a node depend on its nucleotides, on whether it is a base pair,
+ * on its pseudoknot and de novo predicted flags and on whether it is root;
+ * node_class() packs these together, so gted evaluates the costs
+ * only once per pair of classes and not per pair of nodes.
+ *
+ * Root can be updated only to root and base pair only to base pair,
+ * other updates cost `root`, drawing relies on such mapping.
+ *
+ * configuration file has one `name value` per line, `#` starts a comment:
+ *
+ *      delete 1        # delete single base
+ *      insert 1        # insert single base
+ *      delete_pair 1   # delete base pair
+ *      insert_pair 1   # insert base pair
+ *      relabel 0       # change base to other nucleotide
+ *      relabel A G 0   # change template A to target G
+ *      pseudoknot 0    # delete/insert pseudoknot node or change its flag
+ *      de_novo 0       # delete/insert de novo predicted pair or change its flag
+ *      root 10000      # delete/insert root, forbidden updates
+ *
+ * values not set keep defaults, which are the costs of gted::costs
+ */
+class ted_costs
+{
+public:
+    typedef rna_tree::iterator iterator;
+
+public:
+    ted_costs();
+
+    /**
+     * read configuration file
+     */
+    static ted_costs load(
+                          const std::string& filename);
+    /**
+     * read configuration from stream, `name` is used in error messages
+     */
+    static ted_costs parse(
+                           std::istream& in,
+                           const std::string& name);
+    /**
+     * configuration with every value set, parse() reads it back
+     */
+    std::string to_string() const;
+
+public:
+    size_t del(iterator it) const;
+    size_t ins(iterator it) const;
+    size_t upd(iterator it1, iterator it2) const;
+    /**
+     * nodes of the same class have the same costs,
+     * returns value < classes()
+     */
+    size_t node_class(iterator it) const;
+    static size_t classes();
+
+private:
+    /**
+     * index of nucleotide in `relabel`, unknown ones are the last
+     */
+    static size_t nucleotide(
+                             const label_text& label);
+    static size_t nucleotide(
+                             const std::string& label);
+    static bool in_pseudoknot(
+                              iterator it);
+    /**
+     * cost of deleting/inserting node other than root
+     */
+    size_t remove(
+                  iterator it,
+                  size_t single,
+                  size_t pair) const;
+
+private:
+    size_t del_single = 1;
+    size_t ins_single = 1;
+    size_t del_pair = 1;
+    size_t ins_pair = 1;
+    size_t pseudoknot = 0;
+    size_t de_novo = 0;
+    size_t root = 10000;
+    // [template nucleotide][target nucleotide]
+    size_t relabel[TED_COSTS_NUCLEOTIDES][TED_COSTS_NUCLEOTIDES];
+};
+
+#endif /* !TRAVELER_TED_COSTS_HPP */
@@ -34,7 +34,15 @@ public:
     virtual void run();
 
 private:
-    void test_gted(rna_tree rna1, rna_tree rna2, size_t distance);
+    void test_gted(rna_tree rna1, rna_tree rna2, size_t distance = -1);
+    void test_threads();
+    void test_max_distance(rna_tree rna1, rna_tree rna2);
+    void test_lower_bound();
+    void test_costs();
+    void test_helix_tree();
+    void test_coarse_ted();
+    void test_ted_cache();
+    void test_incremental();
 };
 
 #endif /* !GTED_TEST_HPP */
@@ -40,6 +40,10 @@ private:
                 const std::string& b2,
                 const std::string& l2,
                 funct test_funct);
+    void test_fixed_strategy();
+    void test_parallel();
+    void test_subtree_rows();
+    void test_t2_cost_factor();
 };
 
 #endif /* !RTED_TEST_HPP */
@@ -37,6 +37,9 @@ private:
     void test_exist_file();
     void test_io();
     void test_read_fasta_file();
+    void test_string_edit_distance();
+    void test_tables();
+    void test_mapping_tables();
 
     std::string create_fasta_text();
     fasta create_fasta();
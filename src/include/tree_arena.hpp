@@ -0,0 +1,156 @@
+#ifndef TRAVELER_TREE_ARENA_HPP
+#define TRAVELER_TREE_ARENA_HPP
+
+#include <vector>
+#include <algorithm>
+#include <new>
+#include <utility>
+#include <cstddef>
+
+#define TREE_ARENA_FIRST_CHUNK  64
+#define TREE_ARENA_MAX_CHUNK    4096
+// below default malloc mmap threshold, so that chunks are reused by malloc
+#define TREE_ARENA_MAX_CHUNK_BYTES  (64 * 1024)
+
+/**
+ * arena allocator of tree nodes for tree.hh
+ *
+ * nodes are carved from chunks of growing size, so nodes of one tree
+ * built or copied in preorder are contiguous; erased nodes are reused
+ * and all chunks are released at once with the allocator
+ *
+ * each allocator (and tree) owns its arena, copies of an allocator
+ * start with an empty one; nodes must not move between trees
+ */
+template <typename node_type>
+class tree_arena_allocator
+{
+public:
+    typedef node_type       value_type;
+    typedef node_type*      pointer;
+    typedef size_t          size_type;
+
+    template <typename other_type>
+    struct rebind
+    {
+        typedef tree_arena_allocator<other_type> other;
+    };
+
+public:
+    tree_arena_allocator() = default;
+    tree_arena_allocator(
+                         const tree_arena_allocator&)
+    { }
+    tree_arena_allocator& operator=(
+                                    const tree_arena_allocator&)
+    {
+        return *this;
+    }
+    ~tree_arena_allocator()
+    {
+        release();
+    }
+
+public:
+    node_type* allocate(
+                        size_t n,
+                        const void* = nullptr)
+    {
+        if (n != 1)
+            return static_cast<node_type*>(::operator new(n * sizeof(node_type)));
+
+        if (free_list != nullptr)
+        {
+            free_node* node = free_list;
+
+            free_list = node->next;
+            return reinterpret_cast<node_type*>(node);
+        }
+        if (used == capacity)
+            add_chunk();
+
+        return reinterpret_cast<node_type*>(chunks.back()) + used++;
+    }
+    void deallocate(
+                    node_type* p,
+                    size_t n)
+    {
+        if (n != 1)
+        {
+            ::operator delete(p);
+            return;
+        }
+
+        free_node* node = reinterpret_cast<free_node*>(p);
+
+        node->next = free_list;
+        free_list = node;
+    }
+
+    template <typename type, typename... args_type>
+    void construct(
+                   type* p,
+                   args_type&&... args)
+    {
+        new (p) type(std::forward<args_type>(args)...);
+    }
+    template <typename type>
+    void destroy(
+                 type* p)
+    {
+        p->~type();
+    }
+
+    /**
+     * free all chunks, nodes have to be destroyed yet
+     */
+    void release()
+    {
+        for (void* chunk : chunks)
+            ::operator delete(chunk);
+        chunks.clear();
+        free_list = nullptr;
+        used = capacity = 0;
+    }
+
+    inline bool operator==(
+                           const tree_arena_allocator& other) const
+    {
+        return this == &other;
+    }
+    inline bool operator!=(
+                           const tree_arena_allocator& other) const
+    {
+        return this != &other;
+    }
+
+private:
+    struct free_node
+    {
+        free_node* next;
+    };
+    static_assert(sizeof(node_type) >= sizeof(free_node), "node is too small for free list");
+
+    void add_chunk()
+    {
+        size_t size = capacity == 0 ? TREE_ARENA_FIRST_CHUNK : capacity * 2;
+
+        if (size > TREE_ARENA_MAX_CHUNK)
+            size = TREE_ARENA_MAX_CHUNK;
+        if (size * sizeof(node_type) > TREE_ARENA_MAX_CHUNK_BYTES)
+            size = std::max<size_t>(1, TREE_ARENA_MAX_CHUNK_BYTES / sizeof(node_type));
+
+        chunks.push_back(::operator new(size * sizeof(node_type)));
+        used = 0;
+        capacity = size;
+    }
+
+private:
+    std::vector<void*> chunks;
+    free_node* free_list = nullptr;
+    // nodes used/available in the last chunk
+    size_t used = 0;
+    size_t capacity = 0;
+};
+
+#endif /* !TRAVELER_TREE_ARENA_HPP */
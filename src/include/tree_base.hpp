@@ -22,9 +22,14 @@
 #ifndef TREE_BASE_HPP
 #define TREE_BASE_HPP
 
+#include <vector>
+#include <atomic>
+
 #include "tree_hh/tree.hh"
 #undef assert
 #include "types.hpp"
+#include "tree_arena.hpp"
+#include "pair_table.hpp"
 
 //
 // only declarations of classes/functions
@@ -38,7 +43,8 @@ private:
     class                                           _reverse_post_order_iterator;
     
 protected:
-    typedef tree<label_type>                        tree_type;
+    typedef tree<label_type, tree_arena_allocator<tree_node_<label_type>>>
+                                                    tree_type;
     typedef tree_node_<label_type>                  tree_node_type;
     
 public:
@@ -54,10 +60,24 @@ protected:
     
 public:
     virtual ~tree_base() = default;
+    /**
+     * copies get their own index of ids if `other` has one
+     */
+    tree_base(
+              const tree_base<label_type>& other);
+    tree_base<label_type>& operator=(
+                                     const tree_base<label_type>& other);
     template <typename labels_array>
     tree_base(
               const std::string& brackets,
               const labels_array& labels);
+    /**
+     * build tree from parsed structure, `labels[i]` is label of i-th base
+     */
+    template <typename labels_array>
+    tree_base(
+              const pair_table& pairs,
+              const labels_array& labels);
     inline bool operator==(
                            const tree_base<label_type>& other) const;
     
@@ -86,9 +106,32 @@ public:
                                   bool debug_output = true) const;
     
 public:
+    /**
+     * set ids of nodes in postorder and index nodes by them
+     */
     void set_postorder_ids();
 //    void set_pre_postorder_ids(const mapping& mapping);
     bool is_ordered_postorder() const;
+    /**
+     * node with postorder id `id` in O(1); throws illegal_state_exception
+     * if ids are not indexed (structure changed since set_postorder_ids()),
+     * wrong_argument_exception if there is no such id
+     */
+    iterator node_by_id(
+                        size_t id) const;
+    inline bool has_ids_index() const;
+    
+protected:
+    /**
+     * drop index of ids, has to be called on every change of structure
+     */
+    inline void invalidate_ids();
+    
+private:
+    /**
+     * index nodes in postorder, their ids have to be set
+     */
+    void index_ids();
     
 public:
     /* .begin(), .end() functions from tree<> */
@@ -156,12 +199,17 @@ public:
     }
     
 private:
-    static size_t ID;
+    // trees are created also by pool threads
+    static std::atomic<size_t> ID;
     
 protected:
-    size_t _id = ID++;
+    size_t _id = ID.fetch_add(1, std::memory_order_relaxed);
     tree_type _tree;
     size_t _size;
+    
+private:
+    // nodes by postorder id, empty if not indexed
+    std::vector<tree_node_type*> _ids;
 };
 
 
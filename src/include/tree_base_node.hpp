@@ -23,6 +23,7 @@
 #define TREE_BASE_NODE_HPP
 
 #include <cstddef>
+#include <atomic>
 
 class node_base
 {
@@ -34,13 +35,14 @@ protected:
 
 public:
     size_t id() const;
-    void reset_id();
-    static void reset_ID();
+    void set_id(
+                size_t id);
 
 private:
-    static size_t ID;
+    // nodes are created also by pool threads
+    static std::atomic<size_t> ID;
 protected:
-    size_t _id = ID++;
+    size_t _id = ID.fetch_add(1, std::memory_order_relaxed);
 
 };
 
@@ -25,15 +25,13 @@
 #include "tree_base.hpp"
 #include <iostream>
 
-#define PSEUDOKNOT_CHARACTERS "[]{}AaBbCcDdEeFfGgHhIiJjKkLlMmNnOoPpQqRrSsTtUuVvWwXxYyZz"
-
 //
 // tree<> functions:
 //
 
 /* static */
 template <typename label_type>
-size_t tree_base<label_type>::ID = 0;
+std::atomic<size_t> tree_base<label_type>::ID(0);
 
 
 template <typename label_type>
@@ -41,11 +39,18 @@ template <typename labels_array>
 tree_base<label_type>::tree_base(
                                  const std::string& _brackets,
                                  const labels_array& _labels)
+: tree_base(pair_table(_brackets), _labels)
+{ }
+
+template <typename label_type>
+template <typename labels_array>
+tree_base<label_type>::tree_base(
+                                 const pair_table& _pairs,
+                                 const labels_array& _labels)
 {
     APP_DEBUG_FNAME;
 
     iterator it;
-    size_t i = 0;
 
 
     label_type root = label_type(""
@@ -54,34 +59,55 @@ tree_base<label_type>::tree_base(
     _size = 1;  // ROOT
     it = begin();
     
-    while(i < _brackets.size())
+    // only "()" pairs nest nodes, pseudoknotted bases are leaves
+    for (size_t i = 0; i < _pairs.size(); ++i)
     {
-        char ch = _brackets[i];
-        if (ch == '(')
+        if (!_pairs.paired(i) || _pairs.pseudoknot(i))
         {
-            it = _tree.append_child(it, _labels[i]);
+            _tree.append_child(it, _labels[i]);
             ++_size;
         }
-        else if(ch == ')')
-        {
-            assert(!is_root(it));
-            *it = *it + _labels[i];
-            it = parent(it);
-        }
-        else if (ch == '.' || contains(PSEUDOKNOT_CHARACTERS, ch))
+        else if (_pairs.opening(i))
         {
-            _tree.append_child(it, _labels[i]);
+            it = _tree.append_child(it, _labels[i]);
             ++_size;
         }
         else
         {
-            throw wrong_argument_exception("Invalid dot-bracket character '%s' at index %s", ch, i);
+            assert(!is_root(it));
+            *it = *it + _labels[i];
+            it = parent(it);
         }
-        ++i;
     }
     assert(_tree.size() == size());
 }
 
+template <typename label_type>
+tree_base<label_type>::tree_base(
+                                 const tree_base<label_type>& other)
+: _id(other._id), _tree(other._tree), _size(other._size)
+{
+    if (other.has_ids_index())
+        index_ids();
+}
+
+template <typename label_type>
+tree_base<label_type>& tree_base<label_type>::operator=(
+                                                        const tree_base<label_type>& other)
+{
+    if (this == &other)
+        return *this;
+    
+    _id = other._id;
+    _tree = other._tree;
+    _size = other._size;
+    _ids.clear();
+    if (other.has_ids_index())
+        index_ids();
+    
+    return *this;
+}
+
 template <typename label_type>
 bool tree_base<label_type>::operator==(
                                        const tree_base<label_type>& other) const
@@ -161,13 +187,51 @@ void tree_base<label_type>::set_postorder_ids()
     APP_DEBUG_FNAME;
 
     post_order_iterator it;
+    size_t i = 0;
 
-    label_type::reset_ID();
+    // ids are numbered per tree, trees are renumbered also by pool threads
+    for (it = begin_post(); it != end_post(); ++it, ++i)
+        it->set_id(i);
+    index_ids();
+
+    assert(size() - 1 == ::id(begin()));
+}
 
+template <typename label_type>
+void tree_base<label_type>::index_ids()
+{
+    post_order_iterator it;
+
+    _ids.clear();
+    _ids.reserve(size());
     for (it = begin_post(); it != end_post(); ++it)
-        it->reset_id();
+        _ids.push_back(it.node);
+}
 
-    assert(size() - 1 == ::id(begin()));
+template <typename label_type>
+typename tree_base<label_type>::iterator tree_base<label_type>::node_by_id(
+                                                                          size_t id) const
+{
+    if (!has_ids_index())
+        throw illegal_state_exception("Tree ids are not indexed, call set_postorder_ids() first");
+    if (id >= _ids.size())
+        throw wrong_argument_exception("No node with id %s in tree of size %s", id, _ids.size());
+    
+    return iterator(_ids[id]);
+}
+
+/* inline */
+template <typename label_type>
+bool tree_base<label_type>::has_ids_index() const
+{
+    return !_ids.empty();
+}
+
+/* inline */
+template <typename label_type>
+void tree_base<label_type>::invalidate_ids()
+{
+    _ids.clear();
 }
 
 //template <typename label_type>
@@ -544,20 +544,35 @@ template <class T, class tree_node_allocator>
 void tree<T, tree_node_allocator>::copy_(const tree<T, tree_node_allocator>& other) 
 	{
 	clear();
-	pre_order_iterator it=other.begin(), to=begin();
-	while(it!=other.end()) {
-		to=insert(to, (*it));
-		it.skip_children();
-		++it;
-		}
-	to=begin();
-	it=other.begin();
-	while(it!=other.end()) {
-		to=replace(to, it);
-		to.skip_children();
-		it.skip_children();
-		++to;
-		++it;
+	// one preorder pass, every node is appended to the copy of its parent,
+	// so copies are allocated in preorder
+	tree_node *from=other.head->next_sibling, *parent=0;
+	while(from!=other.feet) {
+		tree_node* tmp = alloc_.allocate(1,0);
+		alloc_.construct(tmp, from->data);
+		tmp->parent=parent;
+		if(parent==0) {
+			tmp->prev_sibling=feet->prev_sibling;
+			tmp->next_sibling=feet;
+			feet->prev_sibling->next_sibling=tmp;
+			feet->prev_sibling=tmp;
+			}
+		else {
+			tmp->prev_sibling=parent->last_child;
+			if(parent->last_child==0) parent->first_child=tmp;
+			else                      parent->last_child->next_sibling=tmp;
+			parent->last_child=tmp;
+			}
+		if(from->first_child!=0) {
+			parent=tmp;
+			from=from->first_child;
+			continue;
+			}
+		while(from->parent!=0 && from->next_sibling==0) {
+			from=from->parent;
+			parent=parent->parent;
+			}
+		from=from->next_sibling;
 		}
 	}
 
@@ -42,35 +42,51 @@ struct fasta
 
 /**
  * save strategy `table` to `filename`
- *  format:
+ *  text format:
  *      0-th line:      'm n'
  *      (i+1)-th line:  STR[i][*]
  *  where m = #rows, n = #cols
+ *  or `binary` format of binary_table, with 1-byte elements
  */
 void save_strategy_table(
                          const std::string& filename,
-                         const strategy_table_type& table);
+                         const strategy_table_type& table,
+                         bool binary = false);
 
 /**
- * loads previously saved STR from `filename`
- *  format:
- *      0-th line:      'm n'
- *      (i+1)-th line:  STR[i][*]
- *  where m = #rows, n = #cols
+ * loads previously saved STR from `filename`,
+ * text or binary format is detected
  */
 strategy_table_type load_strategy_table(
                                         const std::string& filename);
 
+/**
+ * the same formats as save_strategy_table, binary elements
+ * are as wide as the biggest distance needs
+ */
 void save_tree_distance_table(
                               const std::string& filename,
-                              const std::vector<std::vector<size_t>>& table);
+                              const std::vector<std::vector<size_t>>& table,
+                              bool binary = false);
 
 std::vector<std::vector<size_t>> load_tree_distance_table(
                                                           const std::string& filename);
 
+/**
+ * `ndjson` selects mapping_writer format with operations and costs
+ * of pairs, otherwise text "DISTANCE: d" and "from to" lines are saved;
+ * load_mapping_table reads both formats
+ */
 void save_tree_mapping_table(
                              const std::string& filename,
-                             const mapping& map);
+                             const mapping& map,
+                             bool ndjson = false);
+
+/**
+ * true if `filename` has NDJSON extension (.ndjson or .jsonl)
+ */
+bool is_ndjson_file(
+                    const std::string& filename);
 
 mapping load_mapping_table(
                            const std::string& filename);
@@ -88,6 +104,24 @@ void write_file(
                 const std::string& filename,
                 const std::string& text);
 
+bool is_directory(
+                  const std::string& path);
+
+/**
+ * unit-cost edit distance between strings,
+ * distances bigger than `limit` are returned as `limit + 1`
+ */
+size_t string_edit_distance(
+                            const std::string& s1,
+                            const std::string& s2,
+                            size_t limit = -1);
+
+/**
+ * returns sorted names of files in directory `dirname`
+ */
+std::vector<std::string> list_directory(
+                                        const std::string& dirname);
+
 fasta read_fasta_file(
                       const std::string& filename);
 
@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <functional>
+
+#include "coarse_ted.hpp"
+#include "helix_tree.hpp"
+#include "gted.hpp"
+#include "rted.hpp"
+
+using namespace std;
+
+#define NONE    ((size_t)-1)
+
+/**
+ * index nodes of `rna` by postorder ids
+ */
+static void index_nodes(
+                        rna_tree& rna,
+                        vector<rna_tree::iterator>& nodes,
+                        vector<size_t>& first)
+{
+    nodes.resize(rna.size());
+    first.resize(rna.size());
+    for (auto it = rna.begin_post(); it != rna.end_post(); ++it)
+    {
+        nodes[id(it)] = it;
+        first[id(it)] = rna_tree::is_leaf(it) ? id(it) : first[id(rna_tree::first_child(it))];
+    }
+}
+
+coarse_ted::coarse_ted(
+                       const rna_tree& _t1,
+                       const rna_tree& _t2)
+: t1(_t1), t2(_t2)
+{ }
+
+void coarse_ted::run(
+                     size_t threads,
+                     size_t max_cells)
+{
+    APP_DEBUG_FNAME;
+
+    INFO("BEG: Running coarse TED for RNAs %s and %s", t1.name(), t2.name());
+
+    helix_tree h1(t1, true);
+    helix_tree h2(t2, true);
+    auto costs = make_shared<helix_costs>();
+
+    // node-level costs of mappings which do not split helices
+    costs->single = costs->helix = costs->stacked = 1;
+
+    gted g(h1.get_tree(), h2.get_tree());
+    g.set_costs(costs);
+    g.run(rted::compute_strategies(h1.get_tree(), h2.get_tree(), threads), threads);
+
+    map = helix_tree::expand(g.get_mapping(), h1, h2);
+    coarse_distance = map.distance;
+    refined = 0;
+
+    index_nodes(t1, nodes1, first1);
+    index_nodes(t2, nodes2, first2);
+    to1.assign(t1.size(), NONE);
+    to2.assign(t2.size(), NONE);
+    for (const mapping::mapping_pair& pair : map.map)
+        if (pair.from != 0 && pair.to != 0)
+        {
+            to1[pair.from - 1] = pair.to - 1;
+            to2[pair.to - 1] = pair.from - 1;
+        }
+
+    // the largest small enough matched subtrees first, their descendants are skipped
+    iterator it = t1.begin();
+    for (++it; it != t1.end(); ++it)
+    {
+        size_t v = id(it);
+        size_t w = to1[v];
+
+        if (w == NONE || (v - first1[v] + 1) * (w - first2[w] + 1) > max_cells)
+            continue;
+
+        size_t distance =
+        count(to1.begin() + first1[v], to1.begin() + v + 1, NONE) +
+        count(to2.begin() + first2[w], to2.begin() + w + 1, NONE);
+
+        if (distance != 0)
+            refine(v, w, distance, threads);
+        it.skip_children();
+    }
+
+    map.map.clear();
+    map.distance = 0;
+    for (size_t v = 0; v < to1.size(); ++v)
+    {
+        map.map.push_back({v + 1, to1[v] == NONE ? 0 : to1[v] + 1, to1[v] == NONE});
+        map.distance += to1[v] == NONE;
+    }
+    for (size_t w = 0; w < to2.size(); ++w)
+        if (to2[w] == NONE)
+        {
+            map.map.push_back({0, w + 1, 1});
+            ++map.distance;
+        }
+    sort(map.map.begin(), map.map.end());
+
+    INFO("END: Running coarse TED for RNAs %s and %s, distance %s (%s before refining %s subtree pairs)",
+         t1.name(), t2.name(), map.distance, coarse_distance, refined);
+}
+
+void coarse_ted::refine(
+                        size_t v,
+                        size_t w,
+                        size_t distance,
+                        size_t threads)
+{
+    rna_tree s1 = subtree(nodes1[v]);
+    rna_tree s2 = subtree(nodes2[w]);
+
+    gted g(s1, s2);
+    g.run(rted::compute_strategies(s1, s2, threads), threads);
+
+    if (g.get_distance() >= distance)
+        return;
+
+    DEBUG("Refined subtrees %s and %s, distance %s -> %s", v, w, distance, g.get_distance());
+
+    mapping sub = g.get_mapping();
+
+    fill(to1.begin() + first1[v], to1.begin() + v + 1, NONE);
+    fill(to2.begin() + first2[w], to2.begin() + w + 1, NONE);
+    for (const mapping::mapping_pair& pair : sub.map)
+    {
+        // roots of s1, s2 are the last nodes and stand for no original node
+        if (pair.from == 0 || pair.to == 0 || pair.from == s1.size())
+            continue;
+
+        size_t x = first1[v] + pair.from - 1;
+        size_t y = first2[w] + pair.to - 1;
+
+        to1[x] = y;
+        to2[y] = x;
+    }
+    ++refined;
+}
+
+/* static */ rna_tree coarse_ted::subtree(
+                                          iterator root)
+{
+    string brackets;
+    vector<iterator> sources;
+
+    function<void(iterator)> add = [&](iterator it) {
+        sources.push_back(it);
+        if (!it->paired())
+        {
+            brackets += '.';
+            return;
+        }
+        brackets += '(';
+        for (rna_tree::sibling_iterator ch = it.begin(); ch != it.end(); ++ch)
+            add(ch);
+        brackets += ')';
+    };
+    add(root);
+
+    rna_tree rna(brackets, "", string(brackets.size(), 'N'));
+    iterator it = rna.begin();
+    size_t i = 0;
+
+    for (++it; it != rna.end(); ++it, ++i)
+        *it = *sources[i];
+    rna.set_postorder_ids();
+
+    return rna;
+}
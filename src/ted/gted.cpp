@@ -23,6 +23,8 @@
 
 #include "gted.hpp"
 #include "mapping.hpp"
+#include "simd.hpp"
+#include "utils.hpp"
 
 
 using namespace std;
@@ -34,273 +36,779 @@ using namespace std;
 (str.is_right() ? (tblname).right : \
 (tblname).heavy))
 
-#define valid(iter) (rna_tree::is_valid(iter))
-
 
 gted::gted(
            const rna_tree& _t1,
            const rna_tree& _t2)
-: t1(_t1), t2(_t2)
+: gted(_t1, make_shared<tree_type>(_t2))
+{ }
+
+gted::gted(
+           const rna_tree& _t1,
+           shared_ptr<tree_type> _t2)
+: tree1(make_shared<tree_type>(_t1)), tree2(_t2), t1(*tree1), t2(*tree2)
 { }
 
+void gted::set_costs(
+                     shared_ptr<const ted_costs> _costs)
+{
+    custom_costs = _costs;
+    stem_costs = nullptr;
+}
+
+void gted::set_costs(
+                     shared_ptr<const helix_costs> _costs)
+{
+    custom_costs = nullptr;
+    stem_costs = _costs;
+}
+
 void gted::run(
-               const strategy_table_type& _str)
+               const strategy_table_type& _str,
+               size_t threads)
 {
     APP_DEBUG_FNAME;
     
     INFO("BEG: Running GTED for RNAs %s and %s", t1.name(), t2.name());
     
-    STR = _str;
+    STR = &_str;
     
     check_ids_postorder();
+    init_costs();
+    check_distance_bound();
+    init_band();
+    
+    tdist.resize(t1.size(), t2.size(), BAD);
+    changed.clear();
+    compute(threads);
+    
+    INFO("END: Running GTED for RNAs %s and %s", t1.name(), t2.name());
+}
+
+void gted::run_incremental(
+                           const strategy_table_type& _str,
+                           const gted& previous,
+                           size_t previous_root,
+                           size_t root,
+                           size_t threads)
+{
+    APP_DEBUG_FNAME;
+    
+    INFO("BEG: Running incremental GTED for RNAs %s and %s", t1.name(), t2.name());
+    
+    STR = &_str;
+    
+    check_ids_postorder();
+    init_costs();
+    check_distance_bound();
+    init_band();
+    
+    // capped cells depend on forest tables they were computed in
+    if (max_distance != GTED_NO_MAX_DISTANCE || previous.max_distance != GTED_NO_MAX_DISTANCE)
+        throw illegal_state_exception("Incremental GTED can not be combined with max distance");
+    
+    // changed subtree occupies postorder ids first .. root
+    const size_t first = root + 1 - t2.get_size(root);
+    const size_t previous_first = previous_root + 1 - previous.t2.get_size(previous_root);
+    
+    if (previous.tdist.rows() != t1.size() || previous.t1.size() != t1.size() ||
+        previous.custom_costs.get() != custom_costs.get() || previous.stem_costs.get() != stem_costs.get() ||
+        first != previous_first ||
+        t2.size() - t2.get_size(root) != previous.t2.size() - previous.t2.get_size(previous_root))
+        throw illegal_state_exception("Previous GTED run does not fit RNAs %s and %s",
+                                      t1.name(), t2.name());
+    
+    // nodes of changed subtree and its ancestors, subtrees of other
+    // nodes are the same as in previous target
+    changed.assign(t2.size(), false);
+    for (size_t w = first; w < t2.size(); ++w)
+        changed[w] = w <= root || w + 1 - t2.get_size(w) <= first;
+    
+    tdist.resize(t1.size(), t2.size(), BAD);
+    for (size_t v = 0; v < t1.size(); ++v)
+    {
+        distance_type* row = tdist.row(v);
+        const distance_type* previous_row = previous.tdist.row(v);
+        
+        for (size_t w = 0; w < t2.size(); ++w)
+            if (!changed[w])
+                row[w] = previous_row[w < first ? w : w - root + previous_root];
+    }
+    DEBUG("Recomputing tdist of %s of %s target subtrees",
+          count(changed.begin(), changed.end(), true), t2.size());
+    
+    compute(threads);
+    changed.clear();
     
-    tdist.resize(t1.size(), vector<size_t>(t2.size(), BAD));
+    INFO("END: Running incremental GTED for RNAs %s and %s", t1.name(), t2.name());
+}
+
+void gted::compute(
+                   size_t threads)
+{
+    workspaces.resize(max(threads, size_t(1)));
+    workspaces[0].fbuffer.reserve(t1.size() + 1, t2.size() + 1);
+    if (threads > 1)
+    {
+        INFO("Running GTED in %s threads, wavefront kernel uses %s", threads, simd::implementation());
+        pool.reset(new task_pool(threads));
+    }
+    
+    compute_distance_recursive(id(t1.begin()), id(t2.begin()));
+    pool.reset();
+    {
+        // roots are computed last, in calling thread's workspace
+        strategy str = (*STR)[id(t1.begin())][id(t2.begin())];
+        root_table_valid = str.is_T1() && str.is_left();
+    }
+    STR = nullptr;
     
-    compute_distance_recursive(t1.begin(), t2.begin());
+    INFO("GTED peak table memory: %s kB", table_memory() / 1024);
     
     INFO("Computed Tree-Edit-Distance between RNAs: tdist[%s][%s] = %s",
          label(t1.begin()), label(t2.begin()),
-         tdist[id(t1.begin())][id(t2.begin())]);
-    
-    INFO("END: Running GTED for RNAs %s and %s", t1.name(), t2.name());
+         tdist(id(t1.begin()), id(t2.begin())));
 }
 
 void gted::compute_distance_recursive(
-                                      iterator root1,
-                                      iterator root2)
+                                      size_t root1,
+                                      size_t root2)
 {
-    // using keyroots
-    t1.check_same_tree(root1);
-    t2.check_same_tree(root2);
+    // incremental run has tdist of unchanged subtrees yet
+    if (!changed.empty() && !changed[root2])
+        return;
     
-    strategy str = STR[id(root1)][id(root2)];
+    // using keyroots
+    strategy str = (*STR)[root1][root2];
     
-    if (str.is_heavy())
+    if (pool)
     {
-        // heavy decomposition is not implemented. Use left or right one.
-        vector<rted_strategy> strategies = {RTED_T1_LEFT, RTED_T1_RIGHT, RTED_T2_LEFT, RTED_T2_RIGHT};
-        str = strategy(strategies.at(rand() % strategies.size()));
+        // keyroot subtrees are disjoint, so their subproblems
+        // write disjoint parts of tdist
+        task_pool::task_group group(*pool);
+        
+        if (str.is_T1())
+        {
+            for (size_t val :
+                 get_table(str, t1.get_keyroots(root1)))
+            {
+                if (t1.get_size(val) * t2.get_size(root2) < GTED_PARALLEL_MIN_CELLS)
+                    compute_distance_recursive(val, root2);
+                else
+                    group.run([this, val, root2]() {
+                        compute_distance_recursive(val, root2);
+                    });
+            }
+        }
+        else
+        {
+            for (size_t val :
+                 get_table(str, t2.get_keyroots(root2)))
+            {
+                if (t1.get_size(root1) * t2.get_size(val) < GTED_PARALLEL_MIN_CELLS)
+                    compute_distance_recursive(root1, val);
+                else
+                    group.run([this, root1, val]() {
+                        compute_distance_recursive(root1, val);
+                    });
+            }
+        }
+        group.wait();
     }
-    actual_str = str;
-    
-    if (str.is_T1())
+    else if (str.is_T1())
     {
-        for (const auto& val :
-             get_table(actual_str, t1.get_keyroots(root1)))
+        for (size_t val :
+             get_table(str, t1.get_keyroots(root1)))
         {
             compute_distance_recursive(val, root2);
         }
     }
     else
     {
-        for (const auto& val :
-             get_table(actual_str, t2.get_keyroots(root2)))
+        for (size_t val :
+             get_table(str, t2.get_keyroots(root2)))
         {
             compute_distance_recursive(root1, val);
         }
     }
     
-    actual_str = str;
-    single_path_function(root1, root2);
+    single_path_function(root1, root2, str);
 }
 
 void gted::single_path_function(
-                                iterator root1,
-                                iterator root2)
+                                size_t root1,
+                                size_t root2,
+                                strategy str)
 {
     // using subforests
     
-    if (actual_str.is_T1())
+    if (str.is_heavy())
     {
-        for (const auto& val :
-             get_table(actual_str, t2.get_subforests(root2)))
-            compute_distance(root1, val);
+        // heavy path function handles all subforests at once
+        compute_distance_heavy(root1, root2, str.is_T2());
+        return;
+    }
+    
+    if (str.is_T1())
+    {
+        // tdist of t1 path and path of unchanged subtree is known yet
+        for (size_t val :
+             get_table(str, t2.get_subforests(root2)))
+            if (changed.empty() || changed[val])
+                compute_distance(root1, val, str);
     }
     else
     {
-        for (const auto& val :
-             get_table(actual_str, t1.get_subforests(root1)))
-            compute_distance(val, root2);
+        for (size_t val :
+             get_table(str, t1.get_subforests(root1)))
+            compute_distance(val, root2, str);
     }
     
-    compute_distance(root1, root2);
+    compute_distance(root1, root2, str);
 }
 
 gted::forest_distance_table_type gted::compute_distance(
-                                                        iterator root1,
-                                                        iterator root2)
+                                                        size_t root1,
+                                                        size_t root2,
+                                                        strategy str)
+{
+    assert(!str.is_heavy());
+    
+    // if T2 -> iterate with T2's nodes in rows
+    return compute_distance_LR(root1, root2, str.is_right(), str.is_T2());
+}
+
+gted::forest_distance_table_type gted::compute_distance_LR(
+                                                           size_t root1,
+                                                           size_t root2,
+                                                           bool right,
+                                                           bool swapped)
 {
-    tree_type *t1ptr = &t1;
-    tree_type *t2ptr = &t2;
-    forest_distance_table_type table;
+    // rows are nodes of tree `a`, columns nodes of tree `b`;
+    // when swapped, `a` is t2 and insert/delete costs exchange roles
+    const tree_type& ta = swapped ? t2 : t1;
+    const tree_type& tb = swapped ? t1 : t2;
+    const gted_tree::ordering& oa = ta.get_ordering(right);
+    const gted_tree::ordering& ob = tb.get_ordering(right);
+    const distance_type* dela = swapped ? ins2.data() : del1.data();
+    const distance_type* insb = swapped ? del1.data() : ins2.data();
+    const uint8_t* classa = swapped ? class2.data() : class1.data();
+    const uint8_t* classb = swapped ? class1.data() : class2.data();
+    // tdist and upd_costs are indexed [t1][t2]
+    const size_t tstridea = swapped ? 1 : tdist.cols();
+    const size_t tstrideb = swapped ? tdist.cols() : 1;
+    const size_t ustridea = swapped ? 1 : classes;
+    const size_t ustrideb = swapped ? classes : 1;
+    
+    // subtree of root `r` occupies indexes lld(r) .. r of ordering,
+    // index `i` is in row/column `i - lld(r) + 1`, 0 is the empty forest
+    const size_t ra = oa.index[swapped ? root2 : root1];
+    const size_t rb = ob.index[swapped ? root1 : root2];
+    const size_t la = oa.lld[ra];
+    const size_t lb = ob.lld[rb];
+    const size_t rows = ra - la + 2;
+    const size_t cols = rb - lb + 2;
+    
+    workspace& ws = get_workspace();
+    forest_distance_table_type fdist = ws.fbuffer.view(rows, cols);
+    size_t r, c;
     
-    if (actual_str.is_T2())
+    ws.lld.resize(cols);
+    ws.tdist_offset.resize(cols);
+    ws.upd_offset.resize(cols);
+    ws.ins.resize(cols);
+    for (c = 1; c < cols; ++c)
     {
-        // if T2 -> iterate with T2's iterators first..
-        swap(t1ptr, t2ptr);
-        swap(root1, root2);
+        const size_t j = lb + c - 1;
+        const size_t idb = ob.ids[j];
+        
+        ws.lld[c] = ob.lld[j] - lb;
+        ws.tdist_offset[c] = idb * tstrideb;
+        ws.upd_offset[c] = classb[idb] * ustrideb;
+        ws.ins[c] = insb[idb];
     }
     
-    t1ptr->check_same_tree(root1);
-    t2ptr->check_same_tree(root2);
+    const size_t* lld = ws.lld.data();
+    const size_t* tdist_offset = ws.tdist_offset.data();
+    const size_t* upd_offset = ws.upd_offset.data();
+    const distance_type* ins = ws.ins.data();
+    
+    fdist(0, 0) = 0;
+    for (c = 1; c < cols; ++c)
+        fdist(0, c) = fdist(0, c - 1) + ins[c];
     
-    if (actual_str.is_left())
+    if (pool && rows * cols >= wavefront_min_cells)
     {
-        auto leaf_funct = [](tree_type& t, iterator root) {
-            return t.get_leafs(root).left;
-        };
-        table = compute_distance_LR<post_order_iterator>(
-                                                         root1, root2, *t1ptr, *t2ptr, leaf_funct);
+        ws.row_lld.resize(rows);
+        ws.row_tdist_offset.resize(rows);
+        ws.row_upd_offset.resize(rows);
+        ws.row_del.resize(rows);
+        for (r = 1; r < rows; ++r)
+        {
+            const size_t i = la + r - 1;
+            const size_t ida = oa.ids[i];
+            
+            ws.row_lld[r] = oa.lld[i] - la;
+            ws.row_tdist_offset[r] = ida * tstridea;
+            ws.row_upd_offset[r] = classa[ida] * ustridea;
+            ws.row_del[r] = dela[ida];
+        }
+        compute_distance_wavefront(fdist, ws);
+        
+        return fdist;
     }
-    else if (actual_str.is_right())
+    
+    for (r = 1; r < rows; ++r)
     {
-        auto leaf_funct = [](const tree_type& t, const iterator& root) {
-            return t.get_leafs(root).right;
+        const size_t i = la + r - 1;
+        const size_t ida = oa.ids[i];
+        const size_t li = oa.lld[i] - la;
+        const distance_type del = dela[ida];
+        const distance_type* upd = upd_costs.data() + classa[ida] * ustridea;
+        distance_type* td = tdist.data() + ida * tstridea;
+        const distance_type* prev = fdist.row(r - 1);
+        const distance_type* left = fdist.row(li);
+        distance_type* cur = fdist.row(r);
+        
+        // forests of cells outside of band differ in size too much
+        const size_t lo = std::min(r > band ? r - band : 1, cols);
+        const size_t hi = r < cols && cols - r > band ? r + band + 1 : cols;
+        auto cap = [&](size_t from, size_t to) {
+            for (c = from; c < to; ++c)
+            {
+                cur[c] = band_cap;
+                if (li == 0 && lld[c] == 0)
+                    td[tdist_offset[c]] = band_cap;
+            }
         };
-        table = compute_distance_LR<rev_post_order_iterator> (
-                                                              root1, root2, *t1ptr, *t2ptr, leaf_funct);
+        
+        cur[0] = prev[0] + del;
+        cap(1, lo);
+        cap(hi, cols);
+        
+        if (li == 0)
+        {
+            // `i`s subtree spans whole row forest, so where column
+            // subtree does the same, both are subtree roots
+            for (c = lo; c < hi; ++c)
+            {
+                distance_type min = std::min(prev[c] + del, cur[c - 1] + ins[c]);
+                
+                if (lld[c] == 0)
+                {
+                    min = std::min(min, prev[c - 1] + upd[upd_offset[c]]);
+                    td[tdist_offset[c]] = min;
+                }
+                else
+                    min = std::min(min, left[lld[c]] + td[tdist_offset[c]]);
+                cur[c] = min;
+            }
+        }
+        else
+        {
+            // tdist of subtree pairs was computed yet
+            for (c = lo; c < hi; ++c)
+            {
+                distance_type min = std::min(prev[c] + del, cur[c - 1] + ins[c]);
+                
+                min = std::min(min, left[lld[c]] + td[tdist_offset[c]]);
+                cur[c] = min;
+            }
+        }
     }
     
-    return table;
+    return fdist;
 }
 
-template <typename iterator_type, typename funct_get_begin>
-gted::forest_distance_table_type gted::compute_distance_LR(
-                                                           iterator root1,
-                                                           iterator root2,
-                                                           tree_type& t1,
-                                                           tree_type& t2,
-                                                           funct_get_begin get_begin_leaf)
+void gted::compute_distance_wavefront(
+                                      forest_distance_table_type& fdist,
+                                      workspace& ws)
 {
-    // subtree has id-s (id(leafs.left) ... id(root1))
-    
-    forest_distance_table_type fdist(
-                                     t1.get_size(root1) + 1,
-                                     vector<size_t>(t2.get_size(root2) + 1, BAD));
-    vector<size_t> vec(3);
-    
-    iterator_type it1, it2;
-    const iterator_type empty;
-    const iterator_type beg1 = get_begin_leaf(t1, root1);
-    const iterator_type beg2 = get_begin_leaf(t2, root2);
-    const iterator_type end1 = ++iterator_type(root1);
-    const iterator_type end2 = ++iterator_type(root2);
-    const size_t id1 = id(t1.get_leafs(root1).left);
-    const size_t id2 = id(t2.get_leafs(root2).left);
-    
-    
-#define prev(num) \
-((it ##num == beg ##num) ? empty : --iterator_type(it ##num))
-#define set_fdist(iter1, iter2, value) \
-set_fdist(fdist, iter1, iter2, value, id1, id2)
-#define get_fdist(iter1, iter2) \
-get_fdist(fdist, iter1, iter2, id1, id2)
-    
-    set_fdist(empty, empty, 0);
-    for (it1 = beg1; it1 != end1; ++it1)
-        set_fdist(it1, empty, get_fdist(prev(1), empty) + costs::del(it1));
-    for (it2 = beg2; it2 != end2; ++it2)
-        set_fdist(empty, it2, get_fdist(empty, prev(2)) + costs::ins(it2));
-    
-    for (it1 = beg1; it1 != end1; ++it1)
+    // cell (r, c) depends on cells of anti-diagonals r + c - 1, r + c - 2
+    // and on jump cell (lld(r), lld(c)) which lies on some earlier one,
+    // so all cells of one anti-diagonal are independent. Last three
+    // diagonals are kept contiguous (indexed by row) and column costs
+    // are reversed, so that the min-of-three can be vectorized.
+    const size_t rows = fdist.rows();
+    const size_t cols = fdist.cols();
+    // band |r - c| <= band of row kernel, on diagonal d it is rows
+    // (d - band) / 2 .. (d + band) / 2
+    const bool banded = band < rows + cols;
+    const size_t* lld = ws.lld.data();
+    const size_t* tdist_offset = ws.tdist_offset.data();
+    const size_t* upd_offset = ws.upd_offset.data();
+    const size_t* row_lld = ws.row_lld.data();
+    const size_t* row_tdist_offset = ws.row_tdist_offset.data();
+    const size_t* row_upd_offset = ws.row_upd_offset.data();
+    const distance_type* ins = ws.ins.data();
+    const distance_type* row_del = ws.row_del.data();
+    distance_type* td = tdist.data();
+    size_t r, c, d;
+    
+    ws.ins_reversed.resize(cols);
+    for (c = 1; c < cols; ++c)
+        ws.ins_reversed[cols - 1 - c] = ins[c];
+    const distance_type* ins_reversed = ws.ins_reversed.data();
+    
+    // rows of nodes whose subtree spans whole row forest
+    ws.tree_rows.clear();
+    for (r = 1; r < rows; ++r)
+    {
+        fdist(r, 0) = fdist(r - 1, 0) + row_del[r];
+        if (row_lld[r] == 0)
+            ws.tree_rows.push_back(r);
+    }
+    
+    for (auto& diagonal : ws.diagonals)
+        diagonal.resize(rows);
+    distance_type* d2 = ws.diagonals[0].data();
+    distance_type* d1 = ws.diagonals[1].data();
+    distance_type* d0 = ws.diagonals[2].data();
+    
+    d2[0] = fdist(0, 0);
+    if (cols > 1)
+        d1[0] = fdist(0, 1);
+    if (rows > 1)
+        d1[1] = fdist(1, 0);
+    
+    auto compute_chunk = [&](size_t beg, size_t end) {
+        distance_type jump[GTED_WAVEFRONT_CHUNK];
+        size_t r;
+        
+        for (r = beg; r < end; ++r)
+            jump[r - beg] = fdist(row_lld[r], lld[d - r]) + td[row_tdist_offset[r] + tdist_offset[d - r]];
+        
+        simd::min3_add(d1 + beg - 1, row_del + beg,
+                       d1 + beg, ins_reversed + (cols - 1 - d + beg),
+                       jump, d0 + beg, end - beg);
+        
+        for (r = beg; r < end; ++r)
+            fdist(r, d - r) = d0[r];
+    };
+    
+    // forests of cells outside of band differ in size too much
+    auto cap = [&](size_t beg, size_t end) {
+        for (r = beg; r < end; ++r)
+        {
+            c = d - r;
+            d0[r] = band_cap;
+            fdist(r, c) = band_cap;
+            if (row_lld[r] == 0 && lld[c] == 0)
+                td[row_tdist_offset[r] + tdist_offset[c]] = band_cap;
+        }
+    };
+    
+    for (d = 2; d + 2 <= rows + cols; ++d)
     {
-        for (it2 = beg2; it2 != end2; ++it2)
+        size_t rbeg = d < cols ? 1 : d - cols + 1;
+        size_t rend = std::min(rows, d);
+        
+        if (d < cols)
+            d0[0] = fdist(0, d);
+        if (d < rows)
+            d0[d] = fdist(d, 0);
+        
+        if (banded)
         {
-            size_t min;
-            bool b = get_begin_leaf(t1, it1) == beg1 &&
-            get_begin_leaf(t2, it2) == beg2;
+            const size_t lo = std::min(std::max(rbeg, d > band ? (d - band + 1) / 2 : 0), rend);
+            const size_t hi = std::max(std::min(rend, (d + band) / 2 + 1), lo);
             
-            vec[0] = get_fdist(prev(1), it2) + costs::del(it1); // delete `it1`
-            vec[1] = get_fdist(it1, prev(2)) + costs::del(it2); // delete `it2`
-
-            // modify iff both it-s are subtree roots
-            if (b)
-                vec[2] = get_fdist(prev(1), prev(2)) + costs::upd(it1, it2); // modify `it1` ~> `it2`
-            else
+            cap(rbeg, lo);
+            cap(hi, rend);
+            rbeg = lo;
+            rend = hi;
+        }
+        
+        if (rend - rbeg <= GTED_WAVEFRONT_CHUNK)
+            compute_chunk(rbeg, rend);
+        else
+        {
+            // kernel uses workspace of this thread, so do not run other tasks
+            task_pool::task_group group(*pool);
+            
+            for (r = rbeg; r + GTED_WAVEFRONT_CHUNK < rend; r += GTED_WAVEFRONT_CHUNK)
             {
-                // previous subtree visited root == --leaf
-                //
-                iterator_type prev_root1 = get_begin_leaf(t1, it1);
-                iterator_type prev_root2 = get_begin_leaf(t2, it2);
-
-                if (prev_root1 != beg1)
-                    --prev_root1;
-                else
-                    prev_root1 = empty;
-                if (prev_root2 != beg2)
-                    --prev_root2;
-                else
-                    prev_root2 = empty;
-
-                vec[2] = get_tdist(it1, it2) + get_fdist(prev_root1, prev_root2);
-                // ^^ if (prev_root != empty) =>
-                // prev_root is in sibling branch of it
-                // and we computed this subtree yet
+                size_t beg = r;
+                
+                group.run([&compute_chunk, beg]() {
+                    compute_chunk(beg, beg + GTED_WAVEFRONT_CHUNK);
+                });
             }
-
-            min = *min_element(vec.begin(), vec.end());
+            compute_chunk(r, rend);
+            group.wait(false);
+        }
+        
+        // pairs of subtree roots were computed as jumps, fix them
+        for (size_t r : ws.tree_rows)
+        {
+            if (r < rbeg || r >= rend || lld[d - r] != 0)
+                continue;
+            
+            c = d - r;
             
-            set_fdist(it1, it2, min);
-            if (b) // i am in subtree roots
-                set_tdist(it1, it2, min);
+            distance_type min = std::min(d1[r - 1] + row_del[r], d1[r] + ins[c]);
+            
+            min = std::min(min, d2[r - 1] + upd_costs[row_upd_offset[r] + upd_offset[c]]);
+            d0[r] = min;
+            fdist(r, c) = min;
+            td[row_tdist_offset[r] + tdist_offset[c]] = min;
         }
+        
+        std::swap(d2, d1);
+        std::swap(d1, d0);
     }
+}
+
+void gted::compute_distance_heavy(
+                                  size_t root1,
+                                  size_t root2,
+                                  bool swapped)
+{
+    // path lies in tree `a`, notation follows compute_distance_LR
+    const tree_type& ta = swapped ? t2 : t1;
+    const tree_type& tb = swapped ? t1 : t2;
+    const size_t roota = swapped ? root2 : root1;
+    const size_t rootb = swapped ? root1 : root2;
+    const distance_type* dela = swapped ? ins2.data() : del1.data();
+    const distance_type* insb = swapped ? del1.data() : ins2.data();
+    const uint8_t* classa = swapped ? class2.data() : class1.data();
+    const uint8_t* classb = swapped ? class1.data() : class2.data();
+    const size_t tstridea = swapped ? 1 : tdist.cols();
+    const size_t tstrideb = swapped ? tdist.cols() : 1;
+    const size_t ustridea = swapped ? 1 : classes;
+    const size_t ustrideb = swapped ? classes : 1;
+    const gted_tree::preordering& prea = ta.get_preordering(false);
+    const gted_tree::preordering& rprea = ta.get_preordering(true);
+    const gted_tree::preordering& preb = tb.get_preordering(false);
+    const gted_tree::preordering& rpreb = tb.get_preordering(true);
     
-    return fdist;
+    // every forest of `b`s subtree reachable by deleting leftmost/rightmost
+    // roots is S(pl, pr) = {x: pre(x) >= pl && rpre(x) >= pr}, where pre/rpre
+    // are local (mirrored) preorder indexes; pl == m or pr == m is empty.
+    // Leftmost root of S(pl, pr) is node `pl` if it is in S, removing it gives
+    // S(pl + 1, pr) and removing its subtree S(pl + size, pr); symmetrically
+    // on the right. Forests of path tree `a` are processed bottom-up along
+    // the path, for each of them one (m + 1) x (m + 1) layer [pl][pr] is kept.
+    const size_t m = tb.get_size(rootb);
+    const size_t preroot = preb.index[rootb];
+    const size_t rpreroot = rpreb.index[rootb];
+    const size_t n = m + 1;
+    size_t pl, pr, s, v;
+    workspace& ws = get_workspace();
+    
+    ws.by_pre.resize(m);
+    ws.by_rpre.resize(m);
+    for (pl = 0; pl < m; ++pl)
+    {
+        const size_t idb = preb.ids[preroot + pl];
+        const size_t rp = rpreb.index[idb] - rpreroot;
+        
+        ws.by_pre[pl] = {rp, tb.get_size(idb), idb * tstrideb,
+            classb[idb] * ustrideb, insb[idb]};
+        ws.by_rpre[rp] = {pl, tb.get_size(idb), idb * tstrideb,
+            classb[idb] * ustrideb, insb[idb]};
+    }
+    const workspace::heavy_node* by_pre = ws.by_pre.data();
+    const workspace::heavy_node* by_rpre = ws.by_rpre.data();
     
-#undef set_fdist
-#undef get_fdist
-#undef prev
+    forest_distance_table_type empty = ws.empty_layer.view(n, n);
+    forest_distance_table_type tree = ws.tree_layer.view(n, n);
+    forest_distance_table_type forest = ws.forest_layer.view(n, n);
+    
+    // empty[pl][pr] = cost of inserting whole S(pl, pr)
+    for (pr = 0; pr < n; ++pr)
+        empty(m, pr) = 0;
+    for (pl = m; pl-- != 0;)
+    {
+        const distance_type* next = empty.row(pl + 1);
+        distance_type* cur = empty.row(pl);
+        
+        for (pr = 0; pr < n; ++pr)
+            cur[pr] = next[pr] + (by_pre[pl].other >= pr ? by_pre[pl].ins : 0);
+    }
+    
+    // forest == distances from empty forest
+    copy(empty.data(), empty.data() + n * n, forest.data());
+    distance_type forest_del = 0;
+    
+    v = ta.get_leafs(roota).heavy;
+    while (true)
+    {
+        // tree step: forest == F_v - v, compute tree == F_v
+        const distance_type dv = dela[v];
+        const distance_type* upd = upd_costs.data() + classa[v] * ustridea;
+        distance_type* td = tdist.data() + v * tstridea;
+        const distance_type tree_del = forest_del + dv;
+        
+        for (pr = 0; pr < n; ++pr)
+            tree(m, pr) = tree_del;
+        for (pl = m; pl-- != 0;)
+        {
+            const workspace::heavy_node& x = by_pre[pl];
+            const distance_type* fcur = forest.row(pl);
+            const distance_type* fnext = forest.row(pl + 1);
+            const distance_type* tnext = tree.row(pl + 1);
+            const distance_type* ecur = empty.row(pl + x.size);
+            distance_type* cur = tree.row(pl);
+            
+            // x is not in S(pl, pr)
+            for (pr = m; pr > x.other; --pr)
+                cur[pr] = tnext[pr];
+            
+            // S(pl, pr) == subtree of x
+            pr = x.other;
+            cur[pr] = std::min(fcur[pr] + dv, tnext[pr] + x.ins);
+            cur[pr] = std::min(cur[pr], fnext[pr] + upd[x.upd_offset]);
+            td[x.tdist_offset] = cur[pr];
+            
+            // x is leftmost root of S(pl, pr)
+            const distance_type subtree = cur[x.other];
+            for (pr = x.other; pr-- != 0;)
+            {
+                distance_type min = std::min(fcur[pr] + dv, tnext[pr] + x.ins);
+                
+                cur[pr] = std::min(min, subtree + ecur[pr]);
+            }
+        }
+        
+        if (v == roota)
+            break;
+        
+        const size_t u = ta.get_parent(v);
+        // siblings of v: right ones in mirrored preorder, left ones in preorder
+        const size_t rbeg = rprea.index[u] + 1;
+        const size_t rend = rprea.index[v];
+        const size_t lbeg = prea.index[u] + 1;
+        const size_t lend = prea.index[v];
+        const size_t stage_rows = max(rend - rbeg, lend - lbeg) + 1;
+        
+        // right stage: forest = F_v . R', R' grows by nodes from the end
+        // of mirrored preorder; S is decomposed on the right, so pl is fixed
+        for (pl = 0; pl < n; ++pl)
+        {
+            forest_distance_table_type X = ws.stage.view(stage_rows, n);
+            distance_type del = tree_del;
+            
+            copy(tree.row(pl), tree.row(pl) + n, X.row(0));
+            for (s = 1; s <= rend - rbeg; ++s)
+            {
+                const size_t r = rprea.ids[rend - s];
+                const distance_type dr = dela[r];
+                const distance_type* tdr = tdist.data() + r * tstridea;
+                const distance_type* prev = X.row(s - 1);
+                const distance_type* jump = X.row(s - ta.get_size(r));
+                distance_type* cur = X.row(s);
+                
+                del += dr;
+                cur[m] = del;
+                for (pr = m; pr-- != 0;)
+                {
+                    const workspace::heavy_node& y = by_rpre[pr];
+                    
+                    if (y.other < pl)
+                        cur[pr] = cur[pr + 1];
+                    else
+                    {
+                        distance_type min = std::min(prev[pr] + dr, cur[pr + 1] + y.ins);
+                        
+                        cur[pr] = std::min(min, tdr[y.tdist_offset] + jump[pr + y.size]);
+                    }
+                }
+            }
+            copy(X.row(s - 1), X.row(s - 1) + n, forest.row(pl));
+        }
+        forest_del = tree_del;
+        for (s = rbeg; s < rend; ++s)
+            forest_del += dela[rprea.ids[s]];
+        
+        // left stage: forest = L' . F_v . R, L' grows by nodes from the end
+        // of preorder; S is decomposed on the left, so pr is fixed
+        if (lbeg != lend)
+        {
+            for (pr = 0; pr < n; ++pr)
+            {
+                forest_distance_table_type X = ws.stage.view(stage_rows, n);
+                distance_type del = forest_del;
+                
+                for (pl = 0; pl < n; ++pl)
+                    X(0, pl) = forest(pl, pr);
+                for (s = 1; s <= lend - lbeg; ++s)
+                {
+                    const size_t l = prea.ids[lend - s];
+                    const distance_type dl = dela[l];
+                    const distance_type* tdl = tdist.data() + l * tstridea;
+                    const distance_type* prev = X.row(s - 1);
+                    const distance_type* jump = X.row(s - ta.get_size(l));
+                    distance_type* cur = X.row(s);
+                    
+                    del += dl;
+                    cur[m] = del;
+                    for (pl = m; pl-- != 0;)
+                    {
+                        const workspace::heavy_node& x = by_pre[pl];
+                        
+                        if (x.other < pr)
+                            cur[pl] = cur[pl + 1];
+                        else
+                        {
+                            distance_type min = std::min(prev[pl] + dl, cur[pl + 1] + x.ins);
+                            
+                            cur[pl] = std::min(min, tdl[x.tdist_offset] + jump[pl + x.size]);
+                        }
+                    }
+                }
+                for (pl = 0; pl < n; ++pl)
+                    forest(pl, pr) = X(s - 1, pl);
+            }
+            for (s = lbeg; s < lend; ++s)
+                forest_del += dela[prea.ids[s]];
+        }
+        
+        v = u;
+    }
 }
 
-mapping gted::get_mapping()
+mapping gted::get_mapping(
+                          mapping_writer* writer)
 {
     APP_DEBUG_FNAME;
     
     INFO("BEG: Computing mapping between RNAs %s and %s",
          t1.name(), t2.name());
     
-    typedef post_order_iterator iterator_type;
-    
     check_ids_postorder();
     
+    if (get_distance() > max_distance)
+        throw illegal_state_exception("Distance between RNAs %s and %s exceeds max distance %s, mapping is not exact",
+                                      t1.name(), t2.name(), max_distance);
+    
     mapping map;
-    vector<pair<iterator_type, iterator_type>> to_be_matched;
+    vector<pair<size_t, size_t>> to_be_matched;
     forest_distance_table_type fdist;
-    const iterator_type empty;
-    size_t id1, id2;
-    iterator_type root1, root2, it1, it2, beg1, beg2;
+    size_t root1, root2, beg1, beg2;
+    // in left ordering index == postorder id, row `i` is node `beg + i - 1`
+    size_t i1, i2;
+    size_t inserted = 0, removed = 0;
     
-    auto get_begin_leaf =
-    [](const tree_type& t, const iterator_type& root) {
-        return t.get_leafs(root).left;
+    auto add_pair =
+    [&map, writer](size_t from, size_t to, size_t cost) {
+        map.map.push_back({from, to, cost});
+        if (writer != nullptr)
+            writer->write(map.map.back());
     };
+    
     auto compute_distance_local =
-    [this](const iterator_type& root1, const iterator_type& root2) {
-        tree_distance_table_type oldtdist = tdist;
-        
-        auto fdist = compute_distance(root1, root2);
-        
-        assert(tdist == oldtdist);
-        return fdist;
-    };
-    auto get_left_subtree =
-    [&empty](iterator_type iter, const iterator_type& root) {
-        while (tree_type::is_first_child(iter) && iter != root)
-            iter = tree_type::parent(iter);
-        
-        if (iter == root)
-            iter = empty;
-        else if (!tree_type::is_first_child(iter))
-            iter = --sibling_iterator(iter);
-        else
-            iter = empty;
-        
-        return iter;
+    [this](size_t root1, size_t root2) {
+        if (root_table_valid)
+        {
+            // left T1 table of roots is still in workspace after run
+            root_table_valid = false;
+            return workspaces[0].fbuffer.view(t1.size() + 1, t2.size() + 1);
+        }
+        return compute_distance(root1, root2, strategy(RTED_T1_LEFT));
     };
     
-    to_be_matched.push_back({t1.begin(), t2.begin()});
-    actual_str = strategy(RTED_T1_LEFT);
+    to_be_matched.push_back({id(t1.begin()), id(t2.begin())});
     
     while (!to_be_matched.empty())
     {
@@ -309,80 +817,76 @@ mapping gted::get_mapping()
         to_be_matched.pop_back();
         
         DEBUG("Matching subtrees: \n%s\n%s",
-              tree_type::print_subtree(root1, false),
-              tree_type::print_subtree(root2, false));
+              tree_type::print_subtree(t1.get_node(root1), false),
+              tree_type::print_subtree(t2.get_node(root2), false));
         
         fdist = compute_distance_local(root1, root2);
         
-        beg1 = get_begin_leaf(t1, root1);
-        beg2 = get_begin_leaf(t2, root2);
-        
-        id1 = id(beg1);
-        id2 = id(beg2);
+        beg1 = t1.get_leafs(root1).left;
+        beg2 = t2.get_leafs(root2).left;
         
-        it1 = root1;
-        it2 = root2;
+        i1 = root1 - beg1 + 1;
+        i2 = root2 - beg2 + 1;
         
-#define prev(num) \
-((it ##num == beg ##num) ? empty : --iterator_type(it ##num))
-#define get_fdist(iter1, iter2) \
-get_fdist(fdist, iter1, iter2, id1, id2)
-        while (tree_type::is_valid(it1) || tree_type::is_valid(it2))
+#define node1   (beg1 + i1 - 1)
+#define node2   (beg2 + i2 - 1)
+        while (i1 != 0 || i2 != 0)
         {
-            if (tree_type::is_valid(it1) &&
-                get_fdist(prev(1), it2) + costs::del(it1) ==
-                get_fdist(it1, it2))
+            if (i1 != 0 &&
+                fdist(i1 - 1, i2) + del1[node1] == fdist(i1, i2))
             {
-                DEBUG("delete %s:%u", label(it1), id(it1));
+                DEBUG("delete %s:%u", label(t1.get_node(node1)), node1);
                 
-                map.map.push_back({id(it1) + 1, 0});
+                add_pair(node1 + 1, 0, del1[node1]);
+                ++removed;
                 
-                it1 = prev(1);
+                --i1;
             }
-            else if (tree_type::is_valid(it2) &&
-                     get_fdist(it1, prev(2)) + costs::ins(it2) ==
-                     get_fdist(it1, it2))
+            else if (i2 != 0 &&
+                     fdist(i1, i2 - 1) + ins2[node2] == fdist(i1, i2))
             {
-                DEBUG("insert %s:%u", label(it2), id(it2));
+                DEBUG("insert %s:%u", label(t2.get_node(node2)), node2);
                 
-                map.map.push_back({0, id(it2) + 1});
+                add_pair(0, node2 + 1, ins2[node2]);
+                ++inserted;
                 
-                it2 = prev(2);
+                --i2;
             }
             else
             {
-                if (get_begin_leaf(t1, it1) == beg1 &&
-                    get_begin_leaf(t2, it2) == beg2)
+                if (t1.get_leafs(node1).left == beg1 &&
+                    t2.get_leafs(node2).left == beg2)
                 {
                     DEBUG("match %s:%u -> %s:%u",
-                          label(it1), id(it1),
-                          label(it2), id(it2));
+                          label(t1.get_node(node1)), node1,
+                          label(t2.get_node(node2)), node2);
                     
-                    map.map.push_back({id(it1) + 1, id(it2) + 1});
+                    add_pair(node1 + 1, node2 + 1, upd_costs[class1[node1] * classes + class2[node2]]);
                     
-                    it1 = prev(1);
-                    it2 = prev(2);
+                    --i1;
+                    --i2;
                 }
                 else
                 {
                     DEBUG("To be matched:\n%s\n%s",
-                          tree_type::print_subtree(it1, false),
-                          tree_type::print_subtree(it2, false));
+                          tree_type::print_subtree(t1.get_node(node1), false),
+                          tree_type::print_subtree(t2.get_node(node2), false));
                     
-                    to_be_matched.push_back({it1, it2});
+                    to_be_matched.push_back({node1, node2});
                     
-                    it1 = get_left_subtree(it1, root1);
-                    it2 = get_left_subtree(it2, root2);
+                    // continue with forest left of matched subtrees
+                    i1 = t1.get_leafs(node1).left - beg1;
+                    i2 = t2.get_leafs(node2).left - beg2;
                 }
             }
         }
-        assert(!tree_type::is_valid(it1) && !tree_type::is_valid(it2));
+#undef node1
+#undef node2
     }
     
-    assert(t1.size() + map.get_to_insert().size() ==
-           t2.size() + map.get_to_remove().size());
+    assert(t1.size() + inserted == t2.size() + removed);
     
-    map.distance = map.get_to_insert().size() + map.get_to_remove().size();
+    map.distance = inserted + removed;
     
     sort(map.map.begin(), map.map.end());
     
@@ -391,101 +895,194 @@ get_fdist(fdist, iter1, iter2, id1, id2)
     
     
     return map;
-    
-#undef prev
-#undef get_fdist
 }
 
 
 
 
 
-/* inline */ size_t gted::get_tdist(
-                                    iterator it1,
-                                    iterator it2)
+void gted::set_max_distance(
+                            size_t k)
 {
-    assert(valid(it1) && valid(it2));
+    max_distance = k;
+}
+
+size_t gted::distance_lower_bound(
+                                  size_t limit)
+{
+    size_t del_min = BAD, ins_min = BAD, cross_min = BAD;
+    size_t excess = 0;
+    size_t c1, c2;
+    size_t bound;
     
-    size_t i1, i2, out;
+    init_costs();
     
-    if (actual_str.is_T2())
-        swap(it1, it2);
-    t1.check_same_tree(it1);
-    t2.check_same_tree(it2);
+    vector<size_t> count1(classes, 0), count2(classes, 0);
     
-    i1 = id(it1);
-    i2 = id(it2);
+    for (size_t i = 0; i < t1.size(); ++i)
+    {
+        del_min = min<size_t>(del_min, del1[i]);
+        ++count1[class1[i]];
+    }
+    for (size_t i = 0; i < t2.size(); ++i)
+    {
+        ins_min = min<size_t>(ins_min, ins2[i]);
+        ++count2[class2[i]];
+    }
+    for (c1 = 0; c1 < classes; ++c1)
+        for (c2 = 0; c2 < classes; ++c2)
+            if (c1 != c2)
+                cross_min = min<size_t>(cross_min, upd_costs[c1 * classes + c2]);
     
-    assert(i1 < tdist.size() && i2 < tdist[i1].size());
+    // at least |size difference| nodes have to be deleted/inserted
+    if (t1.size() >= t2.size())
+        bound = (t1.size() - t2.size()) * del_min;
+    else
+        bound = (t2.size() - t1.size()) * ins_min;
     
-    out = tdist[i1][i2];
+    // node not matched to node of its class is deleted/inserted,
+    // or updated together with one node of other class
+    for (c1 = 0; c1 < classes; ++c1)
+        excess += count1[c1] > count2[c1] ? count1[c1] - count2[c1] : count2[c1] - count1[c1];
+    bound = max(bound, excess * min(min(2 * del_min, 2 * ins_min), cross_min) / 2);
     
-    assert(out != BAD);
+    // each operation changes at most two characters of brackets
+    // (an update changing brackets is an update between classes),
+    // so distance is at least ceil(string distance / 2) operations
+    size_t op_min = min(min(del_min, ins_min), cross_min);
+    if (bound <= limit && op_min != 0)
+    {
+        size_t string_limit = limit == GTED_NO_MAX_DISTANCE ? limit : 2 * (limit / op_min);
+        size_t distance = string_edit_distance(t1.get_brackets(), t2.get_brackets(), string_limit);
+        
+        bound = max(bound, (distance + 1) / 2 * op_min);
+    }
     
-    return out;
+    return bound;
 }
 
-/* inline */ void gted::set_tdist(
-                                  iterator it1,
-                                  iterator it2,
-                                  size_t value)
+gted::distance_type gted::get_distance() const
 {
-    assert(valid(it1) && valid(it2));
+    // root is the last node in postorder
+    return tdist(t1.size() - 1, t2.size() - 1);
+}
+
+void gted::init_band()
+{
+    distance_type cost = BAD;
     
-    size_t i1, i2;
+    band = GTED_NO_MAX_DISTANCE;
+    band_cap = BAD;
     
-    if (actual_str.is_T2())
-        swap(it1, it2);
-    t1.check_same_tree(it1);
-    t2.check_same_tree(it2);
+    if (max_distance >= BAD)
+        return;
     
-    i1 = id(it1);
-    i2 = id(it2);
+    // forests of sizes i and j are at least |i - j| * cost distant
+    for (distance_type value : del1)
+        cost = min(cost, value);
+    for (distance_type value : ins2)
+        cost = min(cost, value);
     
-    assert(i1 < tdist.size() && i2 < tdist[i1].size());
-    assert(value != BAD);
+    if (cost != 0)
+    {
+        band = max_distance / cost;
+        band_cap = distance_type(max_distance + 1);
+        
+        DEBUG("Pruning forest cells more distant than %s, band=%s", max_distance, band);
+    }
+}
+
+size_t gted::table_memory() const
+{
+    size_t bytes = tdist.rows() * tdist.cols() * sizeof(distance_type);
+    
+    for (const workspace& ws : workspaces)
+    {
+        bytes += ws.fbuffer.capacity_bytes();
+        bytes += ws.empty_layer.capacity_bytes();
+        bytes += ws.tree_layer.capacity_bytes();
+        bytes += ws.forest_layer.capacity_bytes();
+        bytes += ws.stage.capacity_bytes();
+    }
     
-    tdist[i1][i2] = value;
+    return bytes;
+}
+
+gted::workspace& gted::get_workspace()
+{
+    return workspaces[pool ? pool->thread_index() : 0];
+}
+
+void gted::init_costs()
+{
+    if (custom_costs)
+        init_costs(*custom_costs);
+    else if (stem_costs)
+        init_costs(*stem_costs);
+    else
+        init_costs(costs());
 }
 
-/* inline */ size_t gted::get_fdist(
-                                    const forest_distance_table_type& fdist,
-                                    const iterator& it1,
-                                    const iterator& it2,
-                                    size_t idleft1,
-                                    size_t idleft2)
+template <typename cost_model>
+void gted::init_costs(
+                      const cost_model& model)
 {
-    size_t i1, i2, out;
+    // class of model -> class in trees
+    vector<size_t> index(model.classes(), BAD);
+    // some node of each class
+    vector<iterator> class_nodes;
+    size_t c1, c2;
     
-    i1 = valid(it1) ? id(it1) - idleft1 + 1 : 0;
-    i2 = valid(it2) ? id(it2) - idleft2 + 1 : 0;
+    auto add_class = [&](iterator it) {
+        size_t& c = index.at(model.node_class(it));
+        
+        if (c == BAD)
+        {
+            c = class_nodes.size();
+            class_nodes.push_back(it);
+        }
+        return uint8_t(c);
+    };
     
-    assert((int)i1 >= 0 && (int)i2 >= 0);
-    assert(i1 < fdist.size() && i2 < fdist[i1].size());
+    assert(model.classes() <= UINT8_MAX + 1);
     
-    out = fdist[i1][i2];
+    del1.resize(t1.size());
+    class1.resize(t1.size());
+    for (auto it = t1.begin_post(); it != t1.end_post(); ++it)
+    {
+        del1[id(it)] = distance_type(model.del(it));
+        class1[id(it)] = add_class(it);
+    }
+    ins2.resize(t2.size());
+    class2.resize(t2.size());
+    for (auto it = t2.begin_post(); it != t2.end_post(); ++it)
+    {
+        ins2[id(it)] = distance_type(model.ins(it));
+        class2[id(it)] = add_class(it);
+    }
     
-    assert(out != BAD);
-    return out;
+    // costs depend only on classes, so nodes of any tree represent them
+    classes = class_nodes.size();
+    upd_costs.resize(classes * classes);
+    for (c1 = 0; c1 < classes; ++c1)
+        for (c2 = 0; c2 < classes; ++c2)
+            upd_costs[c1 * classes + c2] =
+            distance_type(model.upd(class_nodes[c1], class_nodes[c2]));
 }
 
-/* inline */ void gted::set_fdist(
-                                  forest_distance_table_type& fdist,
-                                  const iterator& it1,
-                                  const iterator& it2,
-                                  size_t value,
-                                  size_t idleft1,
-                                  size_t idleft2)
+void gted::check_distance_bound()
 {
-    size_t i1, i2;
-    
-    i1 = valid(it1) ? id(it1) - idleft1 + 1 : 0;
-    i2 = valid(it2) ? id(it2) - idleft2 + 1 : 0;
+    size_t bound = 0;
     
-    assert((int)i1 >= 0 && (int)i2 >= 0);
-    assert(i1 < fdist.size() && i2 < fdist[i1].size());
+    // any distance is at most deleting whole t1 and inserting whole t2
+    for (distance_type cost : del1)
+        bound += cost;
+    for (distance_type cost : ins2)
+        bound += cost;
     
-    fdist[i1][i2] = value;
+    if (bound >= BAD)
+        throw illegal_state_exception("Trees %s and %s are too big, distance bound %s does not fit into distance table",
+                                      t1.name(), t2.name(), bound);
 }
 
 /* inline */ void gted::check_ids_postorder()
@@ -536,3 +1133,14 @@ get_fdist(fdist, iter1, iter2, id1, id2)
         return GTED_COST_MODIFY;
 }
 
+/* static */ size_t gted::costs::node_class(
+                                            iterator it)
+{
+    // upd() depends only on root and paired flags
+    return (rna_tree::is_root(it) ? 2 : 0) + (it->paired() ? 1 : 0);
+}
+
+/* static */ size_t gted::costs::classes()
+{
+    return 4;
+}
@@ -40,56 +40,71 @@ void gted_tree::init()
     assert(id(begin()) == size() - 1);
     
     size_t s = size();
+    size_t i;
     post_order_iterator it;
     sibling_iterator ch;
     LRH lrh;
     
+    nodes.resize(s);
+    parents.resize(s);
     sizes.resize(s, 0);
+    paired.resize(s);
+    roots.resize(s);
     leafs.resize(s);
     heavy_children.resize(s);
     keyroots.resize(s);
     subforests.resize(s);
     
-    for (it = begin_post(); it != end_post(); ++it)
+    i = 0;
+    for (it = begin_post(); it != end_post(); ++it, ++i)
     {
+        assert(id(it) == i);
+        
+        nodes[i] = it;
+        roots[i] = is_root(it);
+        paired[i] = it->paired();
+        parents[i] = is_root(it) ? GTED_TREE_NO_PARENT : id(parent(it));
+        
         // compute sizes
-        sizes[id(it)] = 1;
+        sizes[i] = 1;
         for (ch = it.begin(); ch != it.end(); ++ch)
-            sizes[id(it)] += sizes[id(ch)];
+            sizes[i] += sizes[id(ch)];
         
         // compute heavy_child
         if (!is_leaf(it))
         {
-            iterator h;
+            size_t h;
             size_t max;
             
             ch = it.begin();
             max = sizes[id(ch)];
-            h = ch;
+            h = id(ch);
             
             for (; ch != it.end(); ++ch)
                 if (sizes[id(ch)] > max)
                 {
-                    h = ch;
+                    h = id(ch);
                     max = sizes[id(ch)];
                 }
             heavy_child(it) = h;
         }
+        else
+            heavy_child(it) = i;
         
         // compute leafs
         if (is_leaf(it))
         {
             lrh.left =
             lrh.right =
-            lrh.heavy = it;
+            lrh.heavy = i;
         }
         else
         {
             lrh.left = leafs[id(first_child(it))].left;
             lrh.right = leafs[id(last_child(it))].right;
-            lrh.heavy = leafs[id(heavy_child(it))].heavy;
+            lrh.heavy = leafs[heavy_child(it)].heavy;
         }
-        leafs[id(it)] = lrh;
+        leafs[i] = lrh;
         
         // compute keyroots && subforests
         //
@@ -100,39 +115,78 @@ void gted_tree::init()
         //      (iter == child(parent) && !lie_on_path(iter)))
         for (ch = it.begin(); ch != it.end(); ++ch)
         {
-            auto &subforest = subforests[id(it)];
-            auto &keyroot   = keyroots[id(it)];
+            auto &subforest = subforests[i];
+            auto &keyroot   = keyroots[i];
             size_t chid = id(ch);
             
             insert(subforests[chid].left,  subforest.left);
             insert(subforests[chid].right, subforest.right);
             insert(subforests[chid].heavy, subforest.heavy);
             
-            if (!is_left(ch))
+            if (!is_first_child(ch))
             {
-                keyroot.left.push_back(ch);
-                subforest.left.push_back(ch);
+                keyroot.left.push_back(chid);
+                subforest.left.push_back(chid);
             }
             else
                 insert(keyroots[chid].left, keyroot.left);
             
-            if (!is_right(ch))
+            if (!is_last_child(ch))
             {
-                keyroot.right.push_back(ch);
-                subforest.right.push_back(ch);
+                keyroot.right.push_back(chid);
+                subforest.right.push_back(chid);
             }
             else
                 insert(keyroots[chid].right, keyroot.right);
             
-            if (!is_heavy(ch))
+            if (heavy_child(it) != chid)
             {
-                keyroot.heavy.push_back(ch);
-                subforest.heavy.push_back(ch);
+                keyroot.heavy.push_back(chid);
+                subforest.heavy.push_back(chid);
             }
             else
                 insert(keyroots[chid].heavy, keyroot.heavy);
         }
     }
     
-    assert(size() == get_size(begin()));
+    // left ordering is the postorder itself
+    left_ordering.ids.resize(s);
+    left_ordering.index.resize(s);
+    left_ordering.lld.resize(s);
+    for (i = 0; i < s; ++i)
+    {
+        left_ordering.ids[i] = i;
+        left_ordering.index[i] = i;
+        left_ordering.lld[i] = leafs[i].left;
+    }
+    
+    // right ordering is postorder of mirrored tree
+    right_ordering.ids.resize(s);
+    right_ordering.index.resize(s);
+    right_ordering.lld.resize(s);
+    i = 0;
+    for (reverse_post_order_iterator rit = begin_rev_post(); rit != end_rev_post(); ++rit, ++i)
+    {
+        right_ordering.ids[i] = id(rit);
+        right_ordering.index[id(rit)] = i;
+    }
+    assert(i == s);
+    for (i = 0; i < s; ++i)
+        right_ordering.lld[i] = right_ordering.index[leafs[right_ordering.ids[i]].right];
+    
+    // preorders are reversed postorders of mirrored trees
+    for (auto table : {&left_preordering, &right_preordering})
+    {
+        table->ids.resize(s);
+        table->index.resize(s);
+    }
+    for (i = 0; i < s; ++i)
+    {
+        left_preordering.ids[i] = right_ordering.ids[s - 1 - i];
+        left_preordering.index[left_preordering.ids[i]] = i;
+        right_preordering.ids[i] = left_ordering.ids[s - 1 - i];
+        right_preordering.index[right_preordering.ids[i]] = i;
+    }
+    
+    assert(size() == get_size(id(begin())));
 }
@@ -0,0 +1,176 @@
+#include <algorithm>
+
+#include "helix_tree.hpp"
+
+using namespace std;
+
+helix_tree::helix_tree(
+                       rna_tree rna,
+                       bool compress_loops)
+{
+    APP_DEBUG_FNAME;
+
+    string brackets;
+    // original first node and all original nodes of compressed nodes, in preorder
+    vector<iterator> sources;
+    vector<vector<size_t>> groups;
+
+    compress(rna.begin(), compress_loops, brackets, sources, groups);
+
+    tree = rna_tree(brackets, "", string(brackets.size(), 'N'), rna.name());
+
+    iterator it = tree.begin();
+    size_t i = 0;
+
+    for (++it; it != tree.end(); ++it, ++i)
+    {
+        *it = *sources[i];
+        it->set_compressed_nodes(groups[i].size());
+    }
+    assert(i == groups.size());
+    tree.set_postorder_ids();
+
+    nodes.resize(tree.size());
+    nodes[id(tree.begin())] = {id(rna.begin())};
+    it = tree.begin();
+    i = 0;
+    for (++it; it != tree.end(); ++it, ++i)
+        nodes[id(it)] = move(groups[i]);
+
+    DEBUG("Helices of RNA %s compressed, size %s -> %s", rna.name(), rna.size(), tree.size());
+}
+
+/* static */ void helix_tree::compress(
+                                      iterator parent,
+                                      bool compress_loops,
+                                      std::string& brackets,
+                                      std::vector<iterator>& sources,
+                                      std::vector<std::vector<size_t>>& groups)
+{
+    rna_tree::sibling_iterator ch = parent.begin();
+
+    while (ch != parent.end())
+    {
+        iterator it = ch++;
+
+        sources.push_back(it);
+        groups.push_back({id(it)});
+
+        if (!it->paired())
+        {
+            while (compress_loops && ch != parent.end() && !ch->paired() &&
+                   groups.back().size() < HELIX_TREE_MAX_NODES)
+                groups.back().push_back(id(ch++));
+            brackets += '.';
+            continue;
+        }
+
+        iterator inner = it;
+
+        while (groups.back().size() < HELIX_TREE_MAX_NODES &&
+               !rna_tree::is_leaf(inner) &&
+               rna_tree::is_only_child(rna_tree::first_child(inner)) &&
+               rna_tree::first_child(inner)->paired())
+        {
+            inner = rna_tree::first_child(inner);
+            groups.back().push_back(id(inner));
+        }
+
+        brackets += '(';
+        compress(inner, compress_loops, brackets, sources, groups);
+        brackets += ')';
+    }
+}
+
+/* static */ mapping helix_tree::expand(
+                                        const mapping& map,
+                                        const helix_tree& t1,
+                                        const helix_tree& t2)
+{
+    APP_DEBUG_FNAME;
+
+    mapping result;
+    size_t changed = 0;
+    // ids in mapping are postorder ids + 1, 0 is no node
+    static const vector<size_t> none;
+
+    for (const mapping::mapping_pair& pair : map.map)
+    {
+        const vector<size_t>& nodes1 = pair.from != 0 ? t1.get_nodes(pair.from - 1) : none;
+        const vector<size_t>& nodes2 = pair.to != 0 ? t2.get_nodes(pair.to - 1) : none;
+        size_t i;
+
+        for (i = 0; i < nodes1.size() && i < nodes2.size(); ++i)
+            result.map.push_back({nodes1[i] + 1, nodes2[i] + 1});
+        for (; i < nodes1.size(); ++i, ++changed)
+            result.map.push_back({nodes1[i] + 1, 0, 1});
+        for (; i < nodes2.size(); ++i, ++changed)
+            result.map.push_back({0, nodes2[i] + 1, 1});
+    }
+
+    result.distance = changed;
+    sort(result.map.begin(), result.map.end());
+
+    return result;
+}
+
+size_t helix_costs::del(
+                        iterator it) const
+{
+    return remove(it);
+}
+
+size_t helix_costs::ins(
+                        iterator it) const
+{
+    return remove(it);
+}
+
+size_t helix_costs::upd(
+                        iterator it1,
+                        iterator it2) const
+{
+    if (rna_tree::is_root(it1) != rna_tree::is_root(it2) || it1->paired() != it2->paired())
+        return root;
+    if (rna_tree::is_root(it1))
+        return 0;
+
+    size_t n1 = it1->get_compressed_nodes();
+    size_t n2 = it2->get_compressed_nodes();
+    size_t difference = n1 > n2 ? n1 - n2 : n2 - n1;
+
+    return it1->paired() ? helix_cost(difference) : difference * single;
+}
+
+size_t helix_costs::node_class(
+                               iterator it) const
+{
+    if (rna_tree::is_root(it))
+        return 0;
+
+    assert(it->get_compressed_nodes() <= HELIX_TREE_MAX_NODES);
+
+    return (it->paired() ? HELIX_TREE_MAX_NODES : 0) + it->get_compressed_nodes();
+}
+
+/* static */ size_t helix_costs::classes()
+{
+    return 1 + 2 * HELIX_TREE_MAX_NODES;
+}
+
+size_t helix_costs::remove(
+                           iterator it) const
+{
+    if (rna_tree::is_root(it))
+        return root;
+    if (!it->paired())
+        return it->get_compressed_nodes() * single;
+
+    return helix_cost(it->get_compressed_nodes());
+}
+
+size_t helix_costs::helix_cost(
+                               size_t pairs) const
+{
+    return pairs == 0 ? 0 : helix + (pairs - 1) * stacked;
+}
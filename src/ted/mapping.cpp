@@ -110,3 +110,50 @@ bool mapping::mapping_pair::operator<(
     (from == other.from &&
      to < other.to);
 }
+
+
+mapping_writer::mapping_writer(
+                               const std::string& _filename)
+: filename(_filename), out(_filename)
+{
+    DEBUG("save: %s", filename);
+    
+    out << "{\"format\":\"" MAPPING_NDJSON_FORMAT "\",\"version\":" << MAPPING_NDJSON_VERSION << "}\n";
+}
+
+void mapping_writer::write(
+                           const mapping::mapping_pair& pair)
+{
+    out
+    << "{\"op\":\"" << operation_name(pair.type())
+    << "\",\"from\":" << pair.from
+    << ",\"to\":" << pair.to
+    << ",\"cost\":" << pair.cost
+    << "}\n";
+    distance += pair.cost;
+}
+
+void mapping_writer::finish()
+{
+    out << "{\"distance\":" << distance << "}\n";
+    out.flush();
+    
+    if (out.fail())
+        throw io_exception("mapping_writer(%s) failed", filename);
+}
+
+/* static */ const char* mapping_writer::operation_name(
+                                                        mapping::operation op)
+{
+    switch (op)
+    {
+        case mapping::insert:
+            return "insert";
+        case mapping::remove:
+            return "delete";
+        case mapping::update:
+            return "update";
+    }
+    
+    return "";
+}
@@ -20,16 +20,36 @@
  */
 
 
+#include <array>
+#include <chrono>
+
 #include "rted.hpp"
+#include "task_pool.hpp"
 
-#define RTED_BAD        size_t(-0xBADF00D)
+#define RTED_BAD        rted::cost_type(-0xBADF00D)
+#define RTED_MAX_COST   (RTED_BAD - 1)
+#define RTED_NO_SLOT    size_t(-1)
 #define isbad(value)    ((value) == RTED_BAD)
+#define all_same(v)     (v[0] == v[1] && v[1] == v[2])
 
 // TODO: mozno prepisat podobne ako gted - vytvorit iny rted_tree,
 //  v ktorom budu ulozene vsetky potrebne tabulky
 
 using namespace std;
 
+/**
+ * cost + value stored in 32 bits; value can be "negative" (wrapped),
+ * if the exact sum is not
+ */
+static void add_cost(
+                     rted::cost_type& cost,
+                     size_t value)
+{
+    size_t sum = cost + value;
+    
+    cost = rted::cost_type(min<size_t>(sum, RTED_MAX_COST));
+}
+
 rted::rted(
            const tree_type& _t1,
            const tree_type& _t2)
@@ -40,7 +60,8 @@ rted::rted(
     check_postorder();
 }
 
-void rted::run()
+void rted::run(
+               size_t threads)
 {
     APP_DEBUG_FNAME;
     
@@ -49,27 +70,193 @@ void rted::run()
     INFO("BEG: Computing RTED between RNAs %s and %s",
          t1.name(), t2.name());
     
-    for (post_order_iterator it1 = t1.begin_post(); it1 != t1.end_post(); ++it1)
+    if (threads > 1)
     {
-        for (post_order_iterator it2 = t2.begin_post(); it2 != t2.end_post(); ++it2)
+        size_t ranges = min(threads, t2.size());
+        size_t blocks = min(ranges * RTED_BLOCKS_PER_RANGE, t1.size());
+        
+        split_tables(blocks, ranges);
+        
+        INFO("Computing RTED in %s threads, %s blocks of T1 rows, %s ranges of T2 columns",
+             threads, blocks, ranges);
+        
+        task_pool pool(threads);
+        
+        // block b of range r waits for blocks (b - 1, r) and (b, r - 1),
+        // so blocks on anti-diagonal b + r == diagonal are independent
+        for (size_t diagonal = 0; diagonal + 1 < blocks + ranges; ++diagonal)
         {
+            task_pool::task_group group(pool);
+            
+            for (size_t range = 0; range < ranges && range <= diagonal; ++range)
+            {
+                size_t block = diagonal - range;
+                
+                if (block < blocks)
+                    group.run([this, block, range]() {
+                        compute_block(block, range);
+                    });
+            }
+            group.wait();
+        }
+    }
+    else
+    {
+        split_tables(1, 1);
+        compute_block(0, 0);
+    }
+    DEBUG("Strategy computed, STR=%s", STR[id(t1.begin())][id(t2.begin())]);
+    
+    INFO("RTED peak table memory: %s kB", peak_table_memory() / 1024);
+    
+    INFO("END: Computing RTED between RNAs %s and %s",
+         t1.name(), t2.name());
+}
+
+bool rted::select_fixed_strategy()
+{
+    APP_DEBUG_FNAME;
+    
+    auto start = chrono::steady_clock::now();
+    
+    // number of cells computed by uniform left/right strategy is
+    // (sum of T1 keyroot sizes) * (sum of T2 keyroot sizes),
+    // keyroots are root and nodes with left/right sibling
+    auto keyroot_sizes = [](tree_type& t, size_t& left, size_t& right) {
+        table_type size(t.size(), 1);
+        
+        left = right = 0;
+        for (post_order_iterator it = t.begin_post(); it != t.end_post(); ++it)
+        {
+            for (sibling_iterator ch = it.begin(); ch != it.end(); ++ch)
+                size[id(it)] += size[id(ch)];
+            
+            if (tree_type::is_root(it) || !tree_type::is_first_child(it))
+                left += size[id(it)];
+            if (tree_type::is_root(it) || !tree_type::is_last_child(it))
+                right += size[id(it)];
+        }
+    };
+    size_t left1, right1, left2, right2;
+    
+    keyroot_sizes(t1, left1, right1);
+    keyroot_sizes(t2, left2, right2);
+    
+    size_t cells = t1.size() * t2.size();
+    size_t left = left1 * left2;
+    size_t right = right1 * right2;
+    bool fixed = cells < RTED_FIXED_MAX_CELLS || min(left, right) < RTED_FIXED_MAX_RATIO * cells;
+    
+    if (fixed)
+    {
+        strategy str = strategy(left <= right ? RTED_T1_LEFT : RTED_T1_RIGHT);
+        
+        STR.resize(t1.size(), t2.size(), str);
+    }
+    
+    INFO("Strategy selection for RNAs %s and %s: %s (%s * %s nodes, cells left %s, right %s), took %s ms",
+         t1.name(), t2.name(), fixed ? (left <= right ? "fixed left" : "fixed right") : "optimal",
+         t1.size(), t2.size(), left, right,
+         chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count());
+    
+    return fixed;
+}
+
+void rted::compute_block(
+                         size_t block,
+                         size_t range)
+{
+    size_t first1 = T1_blocks[block];
+    size_t first2 = T2_ranges[range];
+    size_t last2 = T2_ranges[range + 1] - 1;
+    flat_table<w_link>& links = T2_links[block];
+    
+    if (range == 0)
+    {
+        size_t columns = 0;
+        
+        for (const table_type& range_links : T2_range_links)
+            columns += range_links.size();
+        if (columns != 0)
+            links.resize(T1_blocks[block + 1] - first1, columns);
+    }
+    
+    for (size_t it1_id = first1; it1_id < T1_blocks[block + 1]; ++it1_id)
+    {
+        iterator it1 = T1_nodes[it1_id];
+        w_link* row = links.empty() ? nullptr : links.row(it1_id - first1);
+        
+        init_T1_rows(it1, first2, last2);
+        init_T2_columns(first2, last2);
+        
+        // children in previous ranges precede children in this range
+        for (size_t ch_id : T2_range_links[range])
+            update_T2_LRH_w_tables(T2_nodes[ch_id], row[T2_link_index[ch_id]]);
+        
+        for (size_t it2_id = first2; it2_id <= last2; ++it2_id)
+        {
+            iterator it2 = T2_nodes[it2_id];
+            
             first_visit(it1, it2);
             
             size_t c_min = update_STR_table(it1, it2);
             
             if (!tree_type::is_root(it1))
                 update_T1_LRH_v_tables(it1, it2, c_min);
-            if (!tree_type::is_root(it2))
-                update_T2_LRH_w_tables(it2, c_min);
+            if (tree_type::is_root(it2))
+                continue;
             
-     
+            w_link link = {c_min, T2_Lw[it2_id], T2_Rw[it2_id], T2_Hw[it2_id]};
             
+            if (T2_link_index[it2_id] == RTED_NO_SLOT)
+                update_T2_LRH_w_tables(it2, link);
+            else
+                row[T2_link_index[it2_id]] = link;
         }
     }
-    DEBUG("Strategy computed, STR=%s", STR[id(t1.begin())][id(t2.begin())]);
     
-    INFO("END: Computing RTED between RNAs %s and %s",
-         t1.name(), t2.name());
+    if (range + 1 == T2_range_links.size())
+        links.clear();
+}
+
+void rted::split_tables(
+                        size_t blocks,
+                        size_t ranges)
+{
+    assert(blocks <= t1.size() && ranges <= t2.size());
+    
+    T1_blocks.clear();
+    for (size_t i = 0; i <= blocks; ++i)
+        T1_blocks.push_back(i * t1.size() / blocks);
+    T2_ranges.clear();
+    for (size_t i = 0; i <= ranges; ++i)
+        T2_ranges.push_back(i * t2.size() / ranges);
+    
+    T2_link_index.assign(t2.size(), RTED_NO_SLOT);
+    T2_range_links.assign(ranges, table_type());
+    
+    size_t links = 0;
+    
+    for (size_t it2_id = 0; it2_id < t2.size(); ++it2_id)
+    {
+        iterator it2 = T2_nodes[it2_id];
+        
+        if (tree_type::is_root(it2))
+            continue;
+        
+        size_t parent2_id = id(tree_type::parent(it2));
+        size_t range = upper_bound(T2_ranges.begin(), T2_ranges.end(), it2_id) - T2_ranges.begin() - 1;
+        size_t parent_range = upper_bound(T2_ranges.begin(), T2_ranges.end(), parent2_id) - T2_ranges.begin() - 1;
+        
+        if (range != parent_range)
+        {
+            T2_link_index[it2_id] = links++;
+            T2_range_links[parent_range].push_back(it2_id);
+        }
+    }
+    
+    T2_links.clear();
+    T2_links.resize(blocks);
 }
 
 void rted::init()
@@ -80,9 +267,6 @@ void rted::init()
     
     DEBUG("BEG prepare tables");
     
-    strategy_table_type::value_type inner_str;
-    table_type inner_v;
-    
     size1 = t1.size();
     size2 = t2.size();
     
@@ -90,13 +274,20 @@ void rted::init()
     t2.print_tree();
     
     // STR table:
-    inner_str.resize(size2);
-    STR.resize(size1, inner_str);
+    STR.resize(size1, size2);
+    
+    T1_nodes.resize(size1);
+    for (post_order_iterator it = t1.begin_post(); it != t1.end_post(); ++it)
+        T1_nodes[id(it)] = it;
+    T2_nodes.resize(size2);
+    for (post_order_iterator it = t2.begin_post(); it != t2.end_post(); ++it)
+        T2_nodes[id(it)] = it;
+    
+    // {L,R,H}v tables, rows are assigned to nodes in assign_T1_slots:
+    size_t rows = assign_T1_slots();
     
-    // {L,R,H}v tables:
-    inner_v.resize(size2, RTED_BAD);
     for (auto table : {&T1_Lv, &T1_Rv, &T1_Hv})
-        table->resize(size1, inner_v);
+        table->resize(rows, size2, RTED_BAD);
     
     // {L, R, H}w tables:
     for (auto table : {&T2_Lw, &T2_Rw, &T2_Hw})
@@ -104,7 +295,7 @@ void rted::init()
     
     // partial tables:
     T2_Hw_partials.resize(size2);
-    T1_Hv_partials.resize(size1, partial_result_arr(size2));
+    T1_Hv_partials.resize(rows, size2);
     
     // A* = decomposition tables.
     // ALeft/ARight == left/right decomposition
@@ -231,9 +422,9 @@ void rted::init_T1_LRH_v_tables(
     size_t it1_id = id(it1);
     size_t it2_id = id(it2);
     
-    T1_Lv[it1_id][it2_id] =
-    T1_Rv[it1_id][it2_id] =
-    T1_Hv[it1_id][it2_id] = 0;
+    T1_Lv(T1_slots[it1_id], it2_id) =
+    T1_Rv(T1_slots[it1_id], it2_id) =
+    T1_Hv(T1_slots[it1_id], it2_id) = 0;
 }
 
 void rted::init_T2_LRH_w_tables(
@@ -252,76 +443,20 @@ void rted::first_visit(
 {
     size_t it1_id = id(it1);
     size_t it2_id = id(it2);
-    std::vector<bool> vec;
+    std::array<bool, 3> vec;
     
     if (tree_type::is_leaf(it1))
         init_T1_LRH_v_tables(it1, it2);
     if (tree_type::is_leaf(it2))
         init_T2_LRH_w_tables(it2);
     
-#define all_same(v) (v[0] == v[1] && v[1] == v[2])
-    auto init_parent_w_tables = [this](iterator iter2) {
-        if (tree_type::is_root(iter2))
-            return;
-        
-        size_t parent2_id = id(tree_type::parent(iter2));
-        
-        std::vector<bool> vec = {
-            isbad(T2_Lw[parent2_id]),
-            isbad(T2_Rw[parent2_id]),
-            isbad(T2_Hw[parent2_id]),
-        };
-        if (!all_same(vec))
-        {   // should be all inited/not-inited
-            ERR("all_same");
-            LOGGER_PRINT_CONTAINER(vec, "isbad w");
-            abort();
-        }
-        if (vec[0] == true)
-        {
-            assert(tree_type::is_first_child(iter2));
-            
-            T2_Lw[parent2_id] =
-            T2_Rw[parent2_id] =
-            T2_Hw[parent2_id] = 0;
-        }
-    };
-    auto init_parent_v_tables = [this](iterator iter1, iterator iter2) {
-        if (tree_type::is_root(iter1))
-            return;
-        
-        size_t parent1_id = id(tree_type::parent(iter1));
-        size_t it2_id = id(iter2);
-        
-        std::vector<bool> vec = {
-            isbad(T1_Lv[parent1_id][it2_id]),
-            isbad(T1_Rv[parent1_id][it2_id]),
-            isbad(T1_Hv[parent1_id][it2_id]),
-        };
-        if (!all_same(vec))
-        {   // should be all inited/not-inited
-            ERR("all_same");
-            LOGGER_PRINT_CONTAINER(vec, "isbad v");
-            abort();
-        }
-        if (vec[0] == true)
-        {   // init parent
-            assert(tree_type::is_first_child(iter1));
-            
-            T1_Lv[parent1_id][it2_id] =
-            T1_Rv[parent1_id][it2_id] =
-            T1_Hv[parent1_id][it2_id] = 0;
-        }
-    };
-    
-    init_parent_w_tables(it2);
     init_parent_v_tables(it1, it2);
     
     { // it1 should be inited yet
         vec = {
-            isbad(T1_Lv[it1_id][it2_id]),
-            isbad(T1_Rv[it1_id][it2_id]),
-            isbad(T1_Hv[it1_id][it2_id]),
+            isbad(T1_Lv(T1_slots[it1_id], it2_id)),
+            isbad(T1_Rv(T1_slots[it1_id], it2_id)),
+            isbad(T1_Hv(T1_slots[it1_id], it2_id)),
         };
         if (all_same(vec) && vec[0] == true)
         {
@@ -341,39 +476,98 @@ void rted::first_visit(
             abort();
         }
     }
-#undef all_same
+}
+
+void rted::init_parent_v_tables(
+                                iterator it1,
+                                iterator it2)
+{
+    if (tree_type::is_root(it1))
+        return;
+    
+    size_t parent1_id = id(tree_type::parent(it1));
+    size_t it2_id = id(it2);
+    
+    std::array<bool, 3> vec = {
+        isbad(T1_Lv(T1_slots[parent1_id], it2_id)),
+        isbad(T1_Rv(T1_slots[parent1_id], it2_id)),
+        isbad(T1_Hv(T1_slots[parent1_id], it2_id)),
+    };
+    if (!all_same(vec))
+    {   // should be all inited/not-inited
+        ERR("all_same");
+        LOGGER_PRINT_CONTAINER(vec, "isbad v");
+        abort();
+    }
+    if (vec[0] == true)
+    {   // init parent
+        assert(tree_type::is_first_child(it1));
+        
+        T1_Lv(T1_slots[parent1_id], it2_id) =
+        T1_Rv(T1_slots[parent1_id], it2_id) =
+        T1_Hv(T1_slots[parent1_id], it2_id) = 0;
+    }
+}
+
+void rted::init_parent_w_tables(
+                                iterator it2)
+{
+    size_t parent2_id = id(tree_type::parent(it2));
+    
+    std::array<bool, 3> vec = {
+        isbad(T2_Lw[parent2_id]),
+        isbad(T2_Rw[parent2_id]),
+        isbad(T2_Hw[parent2_id]),
+    };
+    if (!all_same(vec))
+    {   // should be all inited/not-inited
+        ERR("all_same");
+        LOGGER_PRINT_CONTAINER(vec, "isbad w");
+        abort();
+    }
+    if (vec[0] == true)
+    {
+        assert(tree_type::is_first_child(it2));
+        
+        T2_Lw[parent2_id] =
+        T2_Rw[parent2_id] =
+        T2_Hw[parent2_id] = 0;
+    }
 }
 
 size_t rted::update_STR_table(
                               iterator it1,
                               iterator it2)
 {
-    std::vector<size_t> vec(6);
+    size_t vec[6];
     size_t it1_id = id(it1);
     size_t it2_id = id(it2);
     
     //      |T1v| * |FLeft(T2w)| + Lv[v,w]
     vec[RTED_T1_LEFT] =
-    T1_Size[it1_id] * T2_FLeft[it2_id] + T1_Lv[it1_id][it2_id];
+    T1_Size[it1_id] * T2_FLeft[it2_id] + T1_Lv(T1_slots[it1_id], it2_id);
     //      |T2w| * |FLeft(T1v)| + Lw[w]
     vec[RTED_T2_LEFT] =
     T2_Size[it2_id] * T1_FLeft[it1_id] + T2_Lw[it2_id];
     //      |T1v| * |FRight(T2w)| + Rv[v,w]
     vec[RTED_T1_RIGHT] =
-    T1_Size[it1_id] * T2_FRight[it2_id] + T1_Rv[it1_id][it2_id];
+    T1_Size[it1_id] * T2_FRight[it2_id] + T1_Rv(T1_slots[it1_id], it2_id);
     //      |T2w| * |FRight(T1v)| + Rw[w]
     vec[RTED_T2_RIGHT] =
     T2_Size[it2_id] * T1_FRight[it1_id] + T2_Rw[it2_id];
     //      |T1v| * |A(T2w)| + Hv[v,w]
     vec[RTED_T1_HEAVY] =
-    T1_Size[it1_id] * T2_A[it2_id] + T1_Hv[it1_id][it2_id];
+    T1_Size[it1_id] * T2_A[it2_id] + T1_Hv(T1_slots[it1_id], it2_id);
     //      |T2w| * |A(T1v)| + Hw[w]
     vec[RTED_T2_HEAVY] =
     T2_Size[it2_id] * T1_A[it1_id] + T2_Hw[it2_id];
     
-    auto c_min_it = min_element(vec.begin(), vec.end());
+    for (size_t index : {RTED_T2_LEFT, RTED_T2_RIGHT, RTED_T2_HEAVY})
+        vec[index] = vec[index] * RTED_T2_COST_FACTOR_PERCENT / 100;
+    
+    auto c_min_it = min_element(vec, vec + 6);
     size_t c_min = *c_min_it;
-    size_t index = distance(vec.begin(), c_min_it);
+    size_t index = distance(vec, c_min_it);
     
     STR[it1_id][it2_id] = strategy(index);
     
@@ -390,13 +584,13 @@ void rted::update_T1_LRH_v_tables(
     size_t parent1_id = id(tree_type::parent(it1));
     
     {   // checks:
-        std::vector<bool> vec = {
-            isbad(T1_Lv[parent1_id][it2_id]),
-            isbad(T1_Rv[parent1_id][it2_id]),
-            isbad(T1_Hv[parent1_id][it2_id]),
-            isbad(T1_Lv[it1_id][it2_id]),
-            isbad(T1_Rv[it1_id][it2_id]),
-            isbad(T1_Hv[it1_id][it2_id])
+        std::array<bool, 6> vec = {
+            isbad(T1_Lv(T1_slots[parent1_id], it2_id)),
+            isbad(T1_Rv(T1_slots[parent1_id], it2_id)),
+            isbad(T1_Hv(T1_slots[parent1_id], it2_id)),
+            isbad(T1_Lv(T1_slots[it1_id], it2_id)),
+            isbad(T1_Rv(T1_slots[it1_id], it2_id)),
+            isbad(T1_Hv(T1_slots[it1_id], it2_id))
         };
         if (std::find(vec.begin(), vec.end(), true) != vec.end())
         {
@@ -407,50 +601,52 @@ void rted::update_T1_LRH_v_tables(
     }
     
     // Lv:
-    T1_Lv[parent1_id][it2_id] +=
-    tree_type::is_first_child(it1) ?
-    T1_Lv[it1_id][it2_id] : c_min;
+    add_cost(T1_Lv(T1_slots[parent1_id], it2_id),
+             tree_type::is_first_child(it1) ?
+             T1_Lv(T1_slots[it1_id], it2_id) : c_min);
     
     // Rv:
-    T1_Rv[parent1_id][it2_id] +=
-    tree_type::is_last_child(it1) ?
-    T1_Rv[it1_id][it2_id] : c_min;
+    add_cost(T1_Rv(T1_slots[parent1_id], it2_id),
+             tree_type::is_last_child(it1) ?
+             T1_Rv(T1_slots[it1_id], it2_id) : c_min);
     
     // Hv:
-    auto res = T1_Hv_partials[parent1_id][it2_id];
+    auto res = T1_Hv_partials(T1_slots[parent1_id], it2_id);
     size_t val;
     
     if (T1_Size[it1_id] > res.subtree_size)
     {
-        val = T1_Hv[it1_id][it2_id] - res.H_value + res.c_min;
+        val = size_t(T1_Hv(T1_slots[it1_id], it2_id)) - res.H_value + res.c_min;
         
-        res.subtree_size = T1_Size[it1_id];
-        res.c_min = c_min;
-        res.H_value = T1_Hv[it1_id][it2_id];
+        res.subtree_size = cost_type(T1_Size[it1_id]);
+        res.c_min = cost_type(min<size_t>(c_min, RTED_MAX_COST));
+        res.H_value = T1_Hv(T1_slots[it1_id], it2_id);
         
-        T1_Hv_partials[parent1_id][it2_id] = res;
+        T1_Hv_partials(T1_slots[parent1_id], it2_id) = res;
     }
     else
         val = c_min;
     
-    T1_Hv[parent1_id][it2_id] += val;
+    add_cost(T1_Hv(T1_slots[parent1_id], it2_id), val);
 }
 
 void rted::update_T2_LRH_w_tables(
                                   iterator it2,
-                                  size_t c_min)
+                                  const w_link& link)
 {
     size_t it2_id = id(it2);
     size_t parent2_id = id(tree_type::parent(it2));
     
+    init_parent_w_tables(it2);
+    
     {   // checks:
-        std::vector<bool> vec = {
+        std::array<bool, 6> vec = {
             isbad(T2_Lw[parent2_id]),
             isbad(T2_Rw[parent2_id]),
             isbad(T2_Hw[parent2_id]),
-            isbad(T2_Lw[it2_id]),
-            isbad(T2_Rw[it2_id]),
-            isbad(T2_Hw[it2_id])
+            isbad(link.Lw),
+            isbad(link.Rw),
+            isbad(link.Hw)
         };
         if (std::find(vec.begin(), vec.end(), true) != vec.end())
         {
@@ -462,31 +658,112 @@ void rted::update_T2_LRH_w_tables(
     }
     
     // Lw:
-    T2_Lw[parent2_id] +=
-    tree_type::is_first_child(it2) ?
-    T2_Lw[it2_id] : c_min;
+    add_cost(T2_Lw[parent2_id],
+             tree_type::is_first_child(it2) ?
+             link.Lw : link.c_min);
     
     // Rw:
-    T2_Rw[parent2_id] +=
-    tree_type::is_last_child(it2) ?
-    T2_Rw[it2_id] : c_min;
+    add_cost(T2_Rw[parent2_id],
+             tree_type::is_last_child(it2) ?
+             link.Rw : link.c_min);
     
     // Hw:
     auto res = T2_Hw_partials[parent2_id];
     
     if (T2_Size[it2_id] > res.subtree_size)
     {
-        T2_Hw[parent2_id] +=
-        T2_Hw[it2_id] - res.H_value + res.c_min;
+        add_cost(T2_Hw[parent2_id],
+                 size_t(link.Hw) - res.H_value + res.c_min);
         
-        res.subtree_size = T2_Size[it2_id];
-        res.c_min = c_min;
-        res.H_value = T2_Hw[it2_id];
+        res.subtree_size = cost_type(T2_Size[it2_id]);
+        res.c_min = cost_type(min<size_t>(link.c_min, RTED_MAX_COST));
+        res.H_value = link.Hw;
         
         T2_Hw_partials[parent2_id] = res;
     }
     else
-        T2_Hw[parent2_id] += c_min;
+        add_cost(T2_Hw[parent2_id], link.c_min);
+}
+
+size_t rted::assign_T1_slots()
+{
+    // the same order of rows as in compute_block(); row of node
+    // is reused by another one after all pairs (node, *) are computed
+    table_type free_slots;
+    size_t rows = 0;
+    
+    T1_slots.assign(t1.size(), RTED_NO_SLOT);
+    for (iterator it : T1_nodes)
+    {
+        for (size_t i = 0; i < 2; ++i)
+        {
+            if (i == 1 && tree_type::is_root(it))
+                break;
+            size_t it1_id = i == 0 ? id(it) : id(tree_type::parent(it));
+            
+            if (T1_slots[it1_id] != RTED_NO_SLOT)
+                continue;
+            if (free_slots.empty())
+                T1_slots[it1_id] = rows++;
+            else
+            {
+                T1_slots[it1_id] = free_slots.back();
+                free_slots.pop_back();
+            }
+        }
+        free_slots.push_back(T1_slots[id(it)]);
+    }
+    
+    return rows;
+}
+
+void rted::init_T1_rows(
+                        iterator it1,
+                        size_t first_id,
+                        size_t last_id)
+{
+    auto init_row = [&](size_t slot) {
+        for (auto table : {&T1_Lv, &T1_Rv, &T1_Hv})
+            fill(table->row(slot) + first_id, table->row(slot) + last_id + 1, RTED_BAD);
+        fill(T1_Hv_partials.row(slot) + first_id, T1_Hv_partials.row(slot) + last_id + 1, t2_hw_partial_result());
+    };
+    
+    if (tree_type::is_leaf(it1))
+        init_row(T1_slots[id(it1)]);
+    if (!tree_type::is_root(it1) && tree_type::is_first_child(it1))
+        init_row(T1_slots[id(tree_type::parent(it1))]);
+}
+
+void rted::init_T2_columns(
+                           size_t first_id,
+                           size_t last_id)
+{
+    for (auto table : {&T2_Lw, &T2_Rw, &T2_Hw})
+        fill(table->begin() + first_id, table->begin() + last_id + 1, RTED_BAD);
+    fill(T2_Hw_partials.begin() + first_id, T2_Hw_partials.begin() + last_id + 1, t2_hw_partial_result());
+}
+
+size_t rted::peak_table_memory() const
+{
+    size_t row = 3 * sizeof(cost_type) + sizeof(t2_hw_partial_result);
+    size_t blocks = T1_blocks.size() - 1;
+    size_t ranges = T2_ranges.size() - 1;
+    size_t links = 0;
+    size_t bytes = 0;
+    
+    for (const table_type& range_links : T2_range_links)
+        links += range_links.size();
+    
+    bytes += t1.size() * t2.size() * sizeof(strategy);
+    bytes += T1_Lv.rows() * t2.size() * row;
+    // 1D tables
+    bytes += (t1.size() + t2.size()) * 6 * sizeof(table_type::value_type);
+    bytes += t2.size() * row;
+    bytes += t1.size() * sizeof(size_t);
+    // links of at most `ranges` blocks are alive at once
+    bytes += min(blocks, ranges) * (t1.size() + blocks - 1) / blocks * links * sizeof(w_link);
+    
+    return bytes;
 }
 
 void rted::check_postorder()
@@ -513,3 +790,20 @@ strategy_table_type& rted::get_strategies()
 {
     return STR;
 }
+
+/* static */ strategy_table_type rted::compute_strategies(
+                                                          const tree_type& t1,
+                                                          const tree_type& t2,
+                                                          size_t threads)
+{
+    strategy_table_type strategies;
+    rted r(t1, t2);
+    
+    if (!r.select_fixed_strategy())
+        r.run(threads);
+    // rted tables are released before gted allocates its own
+    strategies.swap(r.get_strategies());
+    
+    return strategies;
+}
+
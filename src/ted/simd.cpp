@@ -0,0 +1,126 @@
+#include <algorithm>
+
+#include "simd.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#   define SIMD_X86
+#   include <immintrin.h>
+#endif
+
+using namespace std;
+
+typedef void (*min3_add_function)(
+                                  const uint32_t*,
+                                  const uint32_t*,
+                                  const uint32_t*,
+                                  const uint32_t*,
+                                  const uint32_t*,
+                                  uint32_t*,
+                                  size_t);
+
+struct implementation_type
+{
+    min3_add_function min3_add;
+    const char* name;
+};
+
+static void min3_add_scalar(
+                            const uint32_t* a,
+                            const uint32_t* b,
+                            const uint32_t* c,
+                            const uint32_t* d,
+                            const uint32_t* e,
+                            uint32_t* out,
+                            size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        out[i] = min(min(a[i] + b[i], c[i] + d[i]), e[i]);
+}
+
+#ifdef SIMD_X86
+__attribute__((target("sse4.1")))
+static void min3_add_sse(
+                         const uint32_t* a,
+                         const uint32_t* b,
+                         const uint32_t* c,
+                         const uint32_t* d,
+                         const uint32_t* e,
+                         uint32_t* out,
+                         size_t n)
+{
+    size_t i = 0;
+
+#define load(ptr) _mm_loadu_si128((const __m128i*)((ptr) + i))
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i x = _mm_add_epi32(load(a), load(b));
+        __m128i y = _mm_add_epi32(load(c), load(d));
+
+        x = _mm_min_epu32(_mm_min_epu32(x, y), load(e));
+        _mm_storeu_si128((__m128i*)(out + i), x);
+    }
+#undef load
+    min3_add_scalar(a + i, b + i, c + i, d + i, e + i, out + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void min3_add_avx2(
+                          const uint32_t* a,
+                          const uint32_t* b,
+                          const uint32_t* c,
+                          const uint32_t* d,
+                          const uint32_t* e,
+                          uint32_t* out,
+                          size_t n)
+{
+    size_t i = 0;
+
+#define load(ptr) _mm256_loadu_si256((const __m256i*)((ptr) + i))
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i x = _mm256_add_epi32(load(a), load(b));
+        __m256i y = _mm256_add_epi32(load(c), load(d));
+
+        x = _mm256_min_epu32(_mm256_min_epu32(x, y), load(e));
+        _mm256_storeu_si256((__m256i*)(out + i), x);
+    }
+#undef load
+    min3_add_scalar(a + i, b + i, c + i, d + i, e + i, out + i, n - i);
+}
+#endif
+
+static implementation_type select_implementation()
+{
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return {min3_add_avx2, "avx2"};
+    if (__builtin_cpu_supports("sse4.1"))
+        return {min3_add_sse, "sse4.1"};
+#endif
+    return {min3_add_scalar, "scalar"};
+}
+
+static const implementation_type& get_implementation()
+{
+    static const implementation_type impl = select_implementation();
+
+    return impl;
+}
+
+void simd::min3_add(
+                    const uint32_t* a,
+                    const uint32_t* b,
+                    const uint32_t* c,
+                    const uint32_t* d,
+                    const uint32_t* e,
+                    uint32_t* out,
+                    size_t n)
+{
+    get_implementation().min3_add(a, b, c, d, e, out, n);
+}
+
+const char* simd::implementation()
+{
+    return get_implementation().name;
+}
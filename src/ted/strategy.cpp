@@ -27,17 +27,8 @@ using namespace std;
 
 int strategy::to_index() const
 {
-    int out;
-    bool t1 = is_T1();
-    
-    if (is_left())
-        out = t1 ? RTED_T1_LEFT : RTED_T2_LEFT;
-    else if (is_right())
-        out = t1 ? RTED_T1_RIGHT : RTED_T2_RIGHT;
-    else
-        out = t1 ? RTED_T1_HEAVY : RTED_T2_HEAVY;
-    
-    return out;
+    assert(inited());
+    return index;
 }
 
 strategy::strategy(
@@ -45,23 +36,11 @@ strategy::strategy(
 : strategy(static_cast<rted_strategy>(index))
 { }
 
-strategy::strategy(rted_strategy index)
+strategy::strategy(rted_strategy _index)
 {
-    assert(index >= 0 && index < 6);
-    
-    if (is_left(index))
-        str = left;
-    else if (is_right(index))
-        str = right;
-    else
-        str = heavy;
+    assert(_index >= 0 && _index < 6);
     
-    if (is_T1(index))
-        tree = T1;
-    else
-        tree = T2;
-    
-    inited = true;
+    index = _index;
 }
 
 strategy::strategy(
@@ -71,36 +50,34 @@ strategy::strategy(
     assert(contains("LRH", text[0]) && contains("12", text[2]));
     
     if (text[0] == 'L')
-        str = left;
+        index = RTED_T1_LEFT;
     if (text[0] == 'R')
-        str = right;
+        index = RTED_T1_RIGHT;
     if (text[0] == 'H')
-        str = heavy;
+        index = RTED_T1_HEAVY;
     
-    if (text[1] == '1')
-        tree = T1;
     if (text[1] == '2')
-        tree = T2;
-    
-    inited = true;
+        ++index;
+}
+
+bool strategy::inited() const
+{
+    return index != none;
 }
 
 bool strategy::is_left() const
 {
-    assert(inited);
-    return str == left;
+    return is_left(to_index());
 }
 
 bool strategy::is_right() const
 {
-    assert(inited);
-    return str == right;
+    return is_right(to_index());
 }
 
 bool strategy::is_heavy() const
 {
-    assert(inited);
-    return str == heavy;
+    return is_heavy(to_index());
 }
 
 /* static */
@@ -126,14 +103,12 @@ bool strategy::is_heavy(int index)
 
 bool strategy::is_T1() const
 {
-    assert(inited);
-    return tree == T1;
+    return is_T1(to_index());
 }
 
 bool strategy::is_T2() const
 {
-    assert(inited);
-    return tree == T2;
+    return is_T2(to_index());
 }
 
 /* static */
@@ -156,7 +131,7 @@ std::ostream& operator<<(
                          std::ostream& out,
                          strategy str)
 {
-    assert(str.inited);
+    assert(str.inited());
     
     if (str.is_left())
         out << "L";
@@ -177,10 +152,10 @@ std::ostream& operator<<(
                          std::ostream& out, strategy_table_type strategies)
 {
     // do not output root line
-    for (size_t i = 0; i < strategies.size(); ++i)
+    for (size_t i = 0; i < strategies.rows(); ++i)
     {
-        for (auto val : strategies[i])
-            out << val << " ";
+        for (size_t j = 0; j < strategies.cols(); ++j)
+            out << strategies[i][j] << " ";
         out << endl;
     }
     return out;
@@ -0,0 +1,183 @@
+#include <cstdio>
+#include <cstdint>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "json.hpp"
+
+#include "ted_cache.hpp"
+#include "ted_costs.hpp"
+#include "utils.hpp"
+
+using namespace std;
+
+#define TED_CACHE_FORMAT    "traveler-ted-cache"
+#define TED_CACHE_VERSION   3
+
+/**
+ * 64-bit FNV-1a hash of `text`
+ */
+static uint64_t fnv1a(
+                      const std::string& text)
+{
+    uint64_t hash = 14695981039346656037ull;
+
+    for (unsigned char c : text)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+ted_cache::ted_cache(
+                     const std::string& _directory)
+: directory(_directory)
+{
+    if (!is_directory(directory) && mkdir(directory.c_str(), 0777) != 0 && !is_directory(directory))
+        throw io_exception("Cannot create TED cache directory %s", directory);
+}
+
+std::string ted_cache::get_key(
+                               rna_tree& templated,
+                               rna_tree& matched,
+                               const std::string& model,
+                               const ted_costs* costs) const
+{
+    ostringstream key;
+
+    key << model << endl;
+    for (rna_tree* rna : {&templated, &matched})
+    {
+        key
+        << rna->get_brackets() << endl
+        << rna->get_labels() << endl;
+        // custom costs see also pseudoknot and de novo flags of nodes
+        if (costs != nullptr)
+        {
+            for (auto it = rna->begin(); it != rna->end(); ++it)
+                key << costs->node_class(it) << " ";
+            key << endl;
+        }
+    }
+
+    return key.str();
+}
+
+std::string ted_cache::get_file(
+                                const std::string& key) const
+{
+    ostringstream name;
+
+    // hash only picks the file, load() compares the whole key
+    name
+    << hex << setfill('0')
+    << setw(16) << fnv1a(key)
+    << ".json";
+
+    return directory + "/" + name.str();
+}
+
+bool ted_cache::load(
+                     const std::string& key,
+                     mapping& map,
+                     size_t& distance) const
+{
+    string file = get_file(key);
+
+    if (!exist_file(file))
+        return false;
+
+    try
+    {
+        nlohmann::json entry = nlohmann::json::parse(read_file(file));
+
+        if (entry.at("format").get<string>() != TED_CACHE_FORMAT ||
+            entry.at("version").get<int>() != TED_CACHE_VERSION)
+        {
+            WARN("TED cache file %s has other format, it is ignored", file);
+            return false;
+        }
+        if (entry.at("key").get<string>() != key)
+        {
+            INFO("TED cache file %s belongs to other RNAs, it is ignored", file);
+            return false;
+        }
+
+        // indexes, as iterators of json clash with operator!= of types.hpp
+        const nlohmann::json& pairs = entry.at("map");
+
+        map = mapping();
+        map.distance = 0;
+        for (size_t i = 0; i < pairs.size(); ++i)
+        {
+            const nlohmann::json& pair = pairs.at(i);
+
+            map.map.emplace_back(pair.at(0).get<size_t>(), pair.at(1).get<size_t>(), pair.at(2).get<size_t>());
+            map.distance += map.map.back().type() != mapping::update;
+        }
+        distance = entry.at("distance").get<size_t>();
+    }
+    catch (const nlohmann::json::exception& e)
+    {
+        WARN("Broken TED cache file %s is ignored: %s", file, e.what());
+        return false;
+    }
+    catch (const my_exception& e)
+    {
+        WARN("Broken TED cache file %s is ignored: %s", file, e);
+        return false;
+    }
+
+    return true;
+}
+
+void ted_cache::save(
+                     const std::string& key,
+                     const mapping& map,
+                     size_t distance) const
+{
+    // threads of one process may save the same key at once
+    static atomic<size_t> saves(0);
+    string file = get_file(key);
+    string tmp = file + ".tmp" + std::to_string(getpid()) + "." + std::to_string(saves++);
+    nlohmann::json entry = {
+        {"format", TED_CACHE_FORMAT},
+        {"version", TED_CACHE_VERSION},
+        {"key", key},
+        {"distance", distance},
+        {"map", nlohmann::json::array()},
+    };
+
+    for (const mapping::mapping_pair& pair : map.map)
+        entry["map"].push_back({pair.from, pair.to, pair.cost});
+
+    try
+    {
+        ofstream out(tmp);
+
+        out << entry.dump() << endl;
+        if (!out)
+            throw io_exception("Cannot write TED cache file %s", tmp);
+    }
+    catch (const nlohmann::json::exception& e)
+    {
+        remove(tmp.c_str());
+        throw io_exception("Cannot save TED cache file %s: %s", file, e.what());
+    }
+    catch (const my_exception&)
+    {
+        remove(tmp.c_str());
+        throw;
+    }
+    if (rename(tmp.c_str(), file.c_str()) != 0)
+    {
+        remove(tmp.c_str());
+        throw io_exception("Cannot save TED cache file %s", file);
+    }
+}
@@ -0,0 +1,230 @@
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <tuple>
+#include <vector>
+
+#include "ted_costs.hpp"
+#include "exception.hpp"
+
+using namespace std;
+
+#define NUCLEOTIDES     "ACGU"
+
+ted_costs::ted_costs()
+{
+    for (size_t i = 0; i < TED_COSTS_NUCLEOTIDES; ++i)
+        for (size_t j = 0; j < TED_COSTS_NUCLEOTIDES; ++j)
+            relabel[i][j] = 0;
+}
+
+/* static */ ted_costs ted_costs::load(
+                                      const std::string& filename)
+{
+    ifstream in(filename);
+
+    if (!in)
+        throw io_exception("Cannot open cost configuration %s", filename);
+
+    return parse(in, filename);
+}
+
+/* static */ ted_costs ted_costs::parse(
+                                       std::istream& in,
+                                       const std::string& name)
+{
+    ted_costs costs;
+    string line;
+    size_t line_number = 0;
+    // relabel with nucleotides given, applied over the default one
+    vector<tuple<size_t, size_t, size_t>> relabels;
+    size_t relabel_default = 0;
+
+    while (getline(in, line))
+    {
+        ++line_number;
+
+        vector<string> words;
+        string word;
+        istringstream stream(line.substr(0, line.find('#')));
+
+        while (stream >> word)
+            words.push_back(word);
+        if (words.empty())
+            continue;
+
+        auto value = [&]() {
+            size_t pos = 0;
+            long long v = -1;
+
+            try
+            {
+                v = stoll(words.back(), &pos);
+            }
+            catch (const logic_error&)
+            { }
+            if (pos != words.back().size() || v < 0 || v > TED_COSTS_MAX_VALUE)
+                throw wrong_argument_exception("%s:%s: cost from 0 to %s expected, got '%s'",
+                                               name, line_number, TED_COSTS_MAX_VALUE, words.back());
+            return size_t(v);
+        };
+
+        if (words[0] == "relabel" && words.size() == 4)
+            relabels.emplace_back(nucleotide(words[1]), nucleotide(words[2]), value());
+        else if (words.size() != 2)
+            throw wrong_argument_exception("%s:%s: 'name value' expected, got '%s'",
+                                           name, line_number, line);
+        else if (words[0] == "delete")
+            costs.del_single = value();
+        else if (words[0] == "insert")
+            costs.ins_single = value();
+        else if (words[0] == "delete_pair")
+            costs.del_pair = value();
+        else if (words[0] == "insert_pair")
+            costs.ins_pair = value();
+        else if (words[0] == "relabel")
+            relabel_default = value();
+        else if (words[0] == "pseudoknot")
+            costs.pseudoknot = value();
+        else if (words[0] == "de_novo")
+            costs.de_novo = value();
+        else if (words[0] == "root")
+            costs.root = value();
+        else
+            throw wrong_argument_exception("%s:%s: unknown cost '%s'",
+                                           name, line_number, words[0]);
+    }
+
+    for (size_t i = 0; i < TED_COSTS_NUCLEOTIDES; ++i)
+        for (size_t j = 0; j < TED_COSTS_NUCLEOTIDES; ++j)
+            costs.relabel[i][j] = i != j ? relabel_default : 0;
+    for (const auto& r : relabels)
+        costs.relabel[get<0>(r)][get<1>(r)] = get<2>(r);
+
+    return costs;
+}
+
+std::string ted_costs::to_string() const
+{
+    ostringstream out;
+    auto name = [](size_t i) {
+        return i < TED_COSTS_NUCLEOTIDES - 1 ? NUCLEOTIDES[i] : 'N';
+    };
+
+    out
+    << "delete " << del_single << endl
+    << "insert " << ins_single << endl
+    << "delete_pair " << del_pair << endl
+    << "insert_pair " << ins_pair << endl
+    << "pseudoknot " << pseudoknot << endl
+    << "de_novo " << de_novo << endl
+    << "root " << root << endl;
+    for (size_t i = 0; i < TED_COSTS_NUCLEOTIDES; ++i)
+        for (size_t j = 0; j < TED_COSTS_NUCLEOTIDES; ++j)
+            out << "relabel " << name(i) << " " << name(j) << " " << relabel[i][j] << endl;
+
+    return out.str();
+}
+
+size_t ted_costs::del(
+                      iterator it) const
+{
+    return rna_tree::is_root(it) ? root : remove(it, del_single, del_pair);
+}
+
+size_t ted_costs::ins(
+                      iterator it) const
+{
+    return rna_tree::is_root(it) ? root : remove(it, ins_single, ins_pair);
+}
+
+size_t ted_costs::upd(
+                      iterator it1,
+                      iterator it2) const
+{
+    if (rna_tree::is_root(it1) != rna_tree::is_root(it2) || it1->paired() != it2->paired())
+        return root;
+    if (rna_tree::is_root(it1))
+        return 0;
+
+    size_t cost = 0;
+
+    for (size_t i = 0; i < it1->size(); ++i)
+        cost += relabel[nucleotide(it1->at(i).label)][nucleotide(it2->at(i).label)];
+    if (in_pseudoknot(it1) != in_pseudoknot(it2))
+        cost += pseudoknot;
+    if (it1->is_de_novo_predicted() != it2->is_de_novo_predicted())
+        cost += de_novo;
+
+    return cost;
+}
+
+size_t ted_costs::node_class(
+                             iterator it) const
+{
+    if (rna_tree::is_root(it))
+        return 0;
+
+    size_t value = nucleotide(it->at(0).label) * TED_COSTS_NUCLEOTIDES;
+
+    if (it->paired())
+        value += nucleotide(it->at(1).label);
+    value = value * 2 + (in_pseudoknot(it) ? 1 : 0);
+    value = value * 2 + (it->is_de_novo_predicted() ? 1 : 0);
+
+    return 1 + value * 2 + (it->paired() ? 1 : 0);
+}
+
+/* static */ size_t ted_costs::classes()
+{
+    return 1 + TED_COSTS_NUCLEOTIDES * TED_COSTS_NUCLEOTIDES * 2 * 2 * 2;
+}
+
+/* static */ size_t ted_costs::nucleotide(
+                                         const std::string& label)
+{
+    if (label.size() != 1)
+        return TED_COSTS_NUCLEOTIDES - 1;
+
+    return nucleotide(label_text(label));
+}
+
+/* static */ size_t ted_costs::nucleotide(
+                                         const label_text& label)
+{
+    if (label.size() == 1)
+    {
+        char c = char(toupper(label[0]));
+
+        if (c == 'T')
+            c = 'U';
+        for (size_t i = 0; NUCLEOTIDES[i] != 0; ++i)
+            if (NUCLEOTIDES[i] == c)
+                return i;
+    }
+    return TED_COSTS_NUCLEOTIDES - 1;
+}
+
+/* static */ bool ted_costs::in_pseudoknot(
+                                          iterator it)
+{
+    for (size_t i = 0; i < it->size(); ++i)
+        if (!it->at(i).pseudoknot.empty())
+            return true;
+    return false;
+}
+
+size_t ted_costs::remove(
+                         iterator it,
+                         size_t single,
+                         size_t pair) const
+{
+    size_t cost = it->paired() ? pair : single;
+
+    if (in_pseudoknot(it))
+        cost += pseudoknot;
+    if (it->is_de_novo_predicted())
+        cost += de_novo;
+
+    return cost;
+}
@@ -20,10 +20,20 @@
  */
 
 
+#ifndef TESTS
+#define TESTS
+#endif
+
 #include "gted.test.hpp"
 #include "gted.hpp"
+#include "coarse_ted.hpp"
+#include "ted_cache.hpp"
 #include "mapping.hpp"
 
+#include <cstdio>
+#include <sstream>
+#include <thread>
+
 
 // == figure 4, str. 337
 #define LABELS1      "1234565731"
@@ -35,6 +45,31 @@
 #define LABELS22     "212"
 #define BRACKETS22   "(.)"
 
+// unbalanced multibranch loops
+#define LABELS31     "GGACUUGCAAGGCAUGCCAAGUCC"
+#define BRACKETS31   "((.((..)).(((...))).)..)"
+#define LABELS32     "GACUUGGCAAUGCUCAAGGCUUCAGG"
+#define BRACKETS32   "(.((.(...).)).((..)..(.)))"
+
+// differ only in one unpaired base
+#define LABELS41     "GACU"
+#define LABELS42     "GGCU"
+#define BRACKETS4    "(..)"
+
+// one helix of 4 pairs, one of 2 pairs
+#define LABELS51     "GGGGAAAACCCC"
+#define BRACKETS51   "((((....))))"
+#define LABELS52     "GGAAAACC"
+#define BRACKETS52   "((....))"
+
+// 32 with last branch refolded, 32 with longer inner hairpin
+#define LABELS33     "GACUUGGCAAUGCUGACUUAGUCAG"
+#define BRACKETS33   "(.((.(...).)).(.(....).))"
+#define LABELS34     "GACUUGGAACAAUGCUCAAGGCUUCAGG"
+#define BRACKETS34   "(.((.(.....).)).((..)..(.)))"
+
+#define CONSTRAINTS  ""
+
 using namespace std;
 
 static ostream& operator<<(
@@ -53,6 +88,14 @@ static bool operator==(
         m1.to == m2.to;
 }
 
+static ted_costs parse_costs(
+                const string& text)
+{
+    istringstream in(text);
+    
+    return ted_costs::parse(in, "test");
+}
+
 static bool operator==(
                 const mapping& m1,
                 const mapping& m2)
@@ -77,9 +120,21 @@ gted_test::gted_test()
 
 void gted_test::run()
 {
-    test_gted(rna_tree(BRACKETS21, LABELS21, "21"), rna_tree(BRACKETS22, LABELS22, "22"), 1);
-    test_gted(rna_tree(BRACKETS1, LABELS1, "1"), rna_tree(BRACKETS21, LABELS21, "21"), 4);
-    test_gted(rna_tree(BRACKETS1, LABELS1, "1"), rna_tree(BRACKETS22, LABELS22, "22"), 5);
+    test_gted(rna_tree(BRACKETS21, CONSTRAINTS, LABELS21, "21"), rna_tree(BRACKETS22, CONSTRAINTS, LABELS22, "22"), 1);
+    test_gted(rna_tree(BRACKETS1, CONSTRAINTS, LABELS1, "1"), rna_tree(BRACKETS21, CONSTRAINTS, LABELS21, "21"), 4);
+    test_gted(rna_tree(BRACKETS1, CONSTRAINTS, LABELS1, "1"), rna_tree(BRACKETS22, CONSTRAINTS, LABELS22, "22"), 5);
+    test_gted(rna_tree(BRACKETS31, CONSTRAINTS, LABELS31, "31"), rna_tree(BRACKETS32, CONSTRAINTS, LABELS32, "32"));
+    test_gted(rna_tree(BRACKETS32, CONSTRAINTS, LABELS32, "32"), rna_tree(BRACKETS1, CONSTRAINTS, LABELS1, "1"));
+    test_threads();
+    test_max_distance(rna_tree(BRACKETS1, CONSTRAINTS, LABELS1, "1"), rna_tree(BRACKETS22, CONSTRAINTS, LABELS22, "22"));
+    test_max_distance(rna_tree(BRACKETS31, CONSTRAINTS, LABELS31, "31"), rna_tree(BRACKETS32, CONSTRAINTS, LABELS32, "32"));
+    test_max_distance(rna_tree(BRACKETS32, CONSTRAINTS, LABELS32, "32"), rna_tree(BRACKETS1, CONSTRAINTS, LABELS1, "1"));
+    test_lower_bound();
+    test_costs();
+    test_helix_tree();
+    test_coarse_ted();
+    test_ted_cache();
+    test_incremental();
 }
 
 void gted_test::test_gted(
@@ -87,18 +142,433 @@ void gted_test::test_gted(
                 rna_tree rna2,
                 size_t distance)
 {
-    strategy_table_type STR(rna1.size(), strategy_table_type::value_type(rna2.size(), RTED_T1_LEFT));
+    strategy_table_type STR(rna1.size(), rna2.size(), RTED_T1_LEFT);
 
     gted g(rna1, rna2);
     g.run(STR);
     auto m1 = g.get_mapping();
 
-    assert_equals(g.get_mapping().distance, distance);
+    if (distance != size_t(-1))
+        assert_equals(m1.distance, distance);
+
+    // every strategy, also mixed ones, has to give the same mapping
+    for (size_t str = RTED_T1_LEFT; str <= RTED_T2_HEAVY + 1; ++str)
+    {
+        for (size_t i = 0; i < rna1.size(); ++i)
+            for (size_t j = 0; j < rna2.size(); ++j)
+                STR[i][j] = strategy(int(str <= RTED_T2_HEAVY ? str : (i * 7 + j * 3) % (RTED_T2_HEAVY + 1)));
+
+        g.run(STR);
+        auto m2 = g.get_mapping();
+
+        assert_equals(m1, m2);
+    }
+
+    // precomputed target shared by more instances
+    auto target = make_shared<gted_tree>(rna2);
+    gted g1(rna1, target);
+    gted g2(rna1, target);
+    g1.run(STR);
+    g2.run(STR);
+    assert_equals(m1, g1.get_mapping());
+    assert_equals(m1, g2.get_mapping());
+}
+
+void gted_test::test_threads()
+{
+    // trees big enough to schedule keyroot subproblems as tasks
+    auto create = [](const string& motif, size_t count, const string& name) {
+        string brackets = "(";
+        string labels = "A";
+        for (size_t i = 0; i < count; ++i)
+            brackets += motif;
+        brackets += ".)";
+        while (labels.size() < brackets.size())
+            labels += "ACGU"[labels.size() % 4];
+        return rna_tree(brackets, CONSTRAINTS, labels, name);
+    };
+    rna_tree rna1 = create("((..((...)).(((....))..((..))).((...))...)).", 6, "t1");
+    rna_tree rna2 = create(".((..(((....))).((..((...))((...)).))..))", 7, "t2");
+
+    for (int str : {int(RTED_T1_LEFT), int(RTED_T2_RIGHT), int(RTED_T1_HEAVY), RTED_T2_HEAVY + 1})
+    {
+        strategy_table_type STR(rna1.size(), rna2.size());
+        for (size_t i = 0; i < rna1.size(); ++i)
+            for (size_t j = 0; j < rna2.size(); ++j)
+                STR[i][j] = strategy(int(str <= RTED_T2_HEAVY ? str : (i * 5 + j) % (RTED_T2_HEAVY + 1)));
+
+        gted g1(rna1, rna2);
+        g1.run(STR);
+        gted g4(rna1, rna2);
+        g4.run(STR, 4);
+        // every forest table by anti-diagonals
+        gted gw(rna1, rna2);
+        gw.wavefront_min_cells = 0;
+        gw.run(STR, 4);
+
+        assert_equals(g1.get_mapping(), g4.get_mapping());
+        assert_equals(g1.get_mapping(), gw.get_mapping());
+    }
+}
+
 
-    STR = strategy_table_type(rna1.size(), strategy_table_type::value_type(rna2.size(), RTED_T2_RIGHT));
+void gted_test::test_max_distance(
+                rna_tree rna1,
+                rna_tree rna2)
+{
+    strategy_table_type STR(rna1.size(), rna2.size());
+    for (size_t i = 0; i < rna1.size(); ++i)
+        for (size_t j = 0; j < rna2.size(); ++j)
+            STR[i][j] = strategy(int((i * 7 + j * 3) % (RTED_T2_HEAVY + 1)));
+
+    gted g(rna1, rna2);
     g.run(STR);
-    auto m2 = g.get_mapping();
+    size_t distance = g.get_distance();
+    auto m1 = g.get_mapping();
+
+    assert_true(g.distance_lower_bound() <= distance);
+
+    // distances up to max distance are exact, bigger ones only exceed it
+    for (size_t k : {size_t(0), distance / 2, distance - 1, distance, distance + 1, 2 * distance})
+    {
+        gted bounded(rna1, rna2);
+        bounded.set_max_distance(k);
+        bounded.run(STR);
+        // anti-diagonal kernel prunes the same band
+        gted wavefront(rna1, rna2);
+        wavefront.set_max_distance(k);
+        wavefront.wavefront_min_cells = 0;
+        wavefront.run(STR, 4);
+        assert_equals(wavefront.get_distance(), bounded.get_distance());
 
-    assert_equals(m1, m2);
+        if (k >= distance)
+        {
+            assert_equals(size_t(bounded.get_distance()), distance);
+            assert_equals(m1, bounded.get_mapping());
+        }
+        else
+            assert_true(bounded.get_distance() > k);
+    }
+}
+
+void gted_test::test_lower_bound()
+{
+    vector<rna_tree> rnas = {
+        rna_tree(BRACKETS1, CONSTRAINTS, LABELS1, "1"),
+        rna_tree(BRACKETS21, CONSTRAINTS, LABELS21, "21"),
+        rna_tree(BRACKETS22, CONSTRAINTS, LABELS22, "22"),
+        rna_tree(BRACKETS31, CONSTRAINTS, LABELS31, "31"),
+        rna_tree(BRACKETS32, CONSTRAINTS, LABELS32, "32"),
+    };
+
+    for (const rna_tree& rna1 : rnas)
+        for (const rna_tree& rna2 : rnas)
+        {
+            strategy_table_type STR(rna1.size(), rna2.size(), RTED_T1_LEFT);
+            gted g(rna1, rna2);
+            g.run(STR);
+            size_t distance = g.get_distance();
+            size_t bound = g.distance_lower_bound();
+
+            assert_true(bound <= distance);
+            // bound is computed only as far as needed to exceed limit
+            for (size_t limit = 0; limit < bound; ++limit)
+                assert_true(g.distance_lower_bound(limit) > limit);
+            assert_equals(g.distance_lower_bound(bound), bound);
+        }
+}
+
+void gted_test::test_costs()
+{
+    vector<rna_tree> rnas = {
+        rna_tree(BRACKETS1, CONSTRAINTS, LABELS1, "1"),
+        rna_tree(BRACKETS21, CONSTRAINTS, LABELS21, "21"),
+        rna_tree(BRACKETS31, CONSTRAINTS, LABELS31, "31"),
+        rna_tree(BRACKETS32, CONSTRAINTS, LABELS32, "32"),
+    };
+    auto defaults = make_shared<ted_costs>(parse_costs("# defaults\ndelete 1\n\nroot 10000\n"));
+    auto relabel = make_shared<ted_costs>(parse_costs("relabel 1\nrelabel A G 0 # transition\n"));
+    // costs of mapping pairs sum up to the distance
+    auto pair_costs = [](const mapping& map) {
+        size_t sum = 0;
+        for (const mapping::mapping_pair& m : map.map)
+            sum += m.cost;
+        return sum;
+    };
+    
+    // configured default costs give the same results as built-in ones
+    for (const rna_tree& rna1 : rnas)
+        for (const rna_tree& rna2 : rnas)
+        {
+            strategy_table_type STR(rna1.size(), rna2.size(), RTED_T1_LEFT);
+            gted g1(rna1, rna2);
+            gted g2(rna1, rna2);
+            g2.set_costs(defaults);
+            g1.run(STR);
+            g2.run(STR);
+            assert_equals(g1.get_distance(), g2.get_distance());
+            assert_true(g2.distance_lower_bound() <= g2.get_distance());
+            assert_equals(g1.get_mapping(), g2.get_mapping());
+            
+            // label costs are the same in all kernels, bound stays valid
+            g2.set_costs(relabel);
+            g2.run(STR);
+            size_t distance = g2.get_distance();
+            assert_true(distance >= g1.get_distance());
+            assert_true(g2.distance_lower_bound() <= distance);
+            for (size_t str = RTED_T1_LEFT; str <= RTED_T2_HEAVY; ++str)
+            {
+                STR.resize(rna1.size(), rna2.size(), strategy(int(str)));
+                g2.run(STR);
+                assert_equals(g2.get_distance(), distance);
+            }
+            assert_equals(pair_costs(g2.get_mapping()), distance);
+        }
+    
+    // A -> G is cheaper than deleting A and inserting G
+    rna_tree rna1(BRACKETS4, CONSTRAINTS, LABELS41, "41");
+    rna_tree rna2(BRACKETS4, CONSTRAINTS, LABELS42, "42");
+    strategy_table_type STR(rna1.size(), rna2.size(), RTED_T1_LEFT);
+    gted g(rna1, rna2);
+    g.set_costs(make_shared<ted_costs>(parse_costs("relabel 1")));
+    g.run(STR);
+    assert_equals(g.get_distance(), 1);
+    assert_equals(g.get_mapping().distance, 0);
+    assert_equals(pair_costs(g.get_mapping()), 1);
+    g.set_costs(make_shared<ted_costs>(parse_costs("relabel 5")));
+    g.run(STR);
+    assert_equals(g.get_distance(), 2);
+    g.set_costs(relabel);
+    g.run(STR);
+    assert_equals(g.get_distance(), 0);
+    
+    assert_fail(parse_costs("relabel A 1"));
+    assert_fail(parse_costs("delete -1"));
+    assert_fail(parse_costs("delete 1x"));
+    assert_fail(parse_costs("unknown 1"));
+    
+    // configuration is read back the same
+    assert_equals(defaults->to_string(), ted_costs().to_string());
+    assert_equals(parse_costs(relabel->to_string()).to_string(), relabel->to_string());
+}
+
+/**
+ * postorder id of `n`-th base pair of `rna` in preorder
+ */
+static size_t pair_id(
+                      rna_tree& rna,
+                      size_t n)
+{
+    for (rna_tree::iterator it = ++rna.begin(); it != rna.end(); ++it)
+        if (it->paired() && n-- == 0)
+            return id(it);
+    throw illegal_state_exception("pair_id(%s) not found", n);
 }
 
+void gted_test::test_incremental()
+{
+    vector<rna_tree> rnas = {
+        rna_tree(BRACKETS1, CONSTRAINTS, LABELS1, "1"),
+        rna_tree(BRACKETS31, CONSTRAINTS, LABELS31, "31"),
+        rna_tree(BRACKETS32, CONSTRAINTS, LABELS32, "32"),
+    };
+    rna_tree previous(BRACKETS32, CONSTRAINTS, LABELS32, "32");
+    // changed target and index of its changed pair, the same in previous one
+    vector<pair<rna_tree, size_t>> changes = {
+        {rna_tree(BRACKETS33, CONSTRAINTS, LABELS33, "33"), 4},
+        {rna_tree(BRACKETS34, CONSTRAINTS, LABELS34, "34"), 3},
+    };
+    
+    for (rna_tree& rna1 : rnas)
+        for (auto& change : changes)
+        {
+            rna_tree& rna2 = change.first;
+            size_t previous_root = pair_id(previous, change.second);
+            size_t root = pair_id(rna2, change.second);
+            strategy_table_type STR1(rna1.size(), previous.size());
+            strategy_table_type STR2(rna1.size(), rna2.size());
+            
+            strategy_table_type STR(rna1.size(), rna2.size(), RTED_T1_LEFT);
+            gted full(rna1, rna2);
+            full.run(STR);
+            
+            // previous and incremental runs with any strategies give the exact result
+            for (size_t str = RTED_T1_LEFT; str <= RTED_T2_HEAVY + 1; ++str)
+            {
+                for (size_t i = 0; i < rna1.size(); ++i)
+                {
+                    for (size_t j = 0; j < previous.size(); ++j)
+                        STR1[i][j] = strategy(int(str <= RTED_T2_HEAVY ? str : (i * 5 + j * 3) % (RTED_T2_HEAVY + 1)));
+                    for (size_t j = 0; j < rna2.size(); ++j)
+                        STR2[i][j] = strategy(int(str <= RTED_T2_HEAVY ? str : (i * 3 + j * 7) % (RTED_T2_HEAVY + 1)));
+                }
+                
+                gted g1(rna1, previous);
+                g1.run(STR1);
+                gted g2(rna1, rna2);
+                g2.run_incremental(STR2, g1, previous_root, root);
+                
+                assert_equals(g2.get_distance(), full.get_distance());
+                assert_equals(g2.get_mapping(), full.get_mapping());
+                
+                // changed subtree has to be the only difference
+                gted g3(rna1, rna2);
+                assert_fail(g3.run_incremental(STR2, g1, previous_root, root - 1));
+            }
+        }
+}
+
+void gted_test::test_ted_cache()
+{
+    rna_tree rna1(BRACKETS4, CONSTRAINTS, LABELS41, "41");
+    rna_tree rna2(BRACKETS4, CONSTRAINTS, LABELS42, "42");
+    auto costs = make_shared<ted_costs>(parse_costs("relabel 1"));
+    ted_cache cache("/tmp/gted-test-cache");
+    
+    // every input of TED changes the key
+    string key = cache.get_key(rna1, rna2, "exact", nullptr);
+    assert_equals(cache.get_key(rna1, rna2, "exact", nullptr), key);
+    assert_true(cache.get_key(rna2, rna1, "exact", nullptr) != key);
+    assert_true(cache.get_key(rna1, rna1, "exact", nullptr) != key);
+    assert_true(cache.get_key(rna1, rna2, "stems", nullptr) != key);
+    assert_true(cache.get_key(rna1, rna2, "exact", costs.get()) != key);
+    
+    strategy_table_type STR(rna1.size(), rna2.size(), RTED_T1_LEFT);
+    gted g(rna1, rna2);
+    g.run(STR);
+    mapping map;
+    size_t distance = 0;
+    string file = cache.get_file(key);
+    
+    remove(file.c_str());
+    assert_false(cache.load(key, map, distance));
+    cache.save(key, g.get_mapping(), g.get_distance());
+    assert_true(cache.load(key, map, distance));
+    assert_equals(map, g.get_mapping());
+    assert_equals(distance, g.get_distance());
+    
+    // threads saving the same key never publish a mixed entry
+    const mapping saved = g.get_mapping();
+    const size_t saved_distance = g.get_distance();
+    
+    for (size_t round = 0; round < 20; ++round)
+    {
+        vector<thread> savers;
+        
+        remove(file.c_str());
+        for (size_t i = 0; i < 4; ++i)
+            savers.emplace_back([&cache, &key, &saved, saved_distance]() {
+                cache.save(key, saved, saved_distance);
+            });
+        for (thread& saver : savers)
+            saver.join();
+        assert_true(cache.load(key, map, distance));
+        assert_equals(map, saved);
+        assert_equals(distance, saved_distance);
+    }
+    
+    // entry of other key in the same file is a miss
+    string other = cache.get_key(rna2, rna1, "exact", nullptr);
+    rename(file.c_str(), cache.get_file(other).c_str());
+    assert_false(cache.load(other, map, distance));
+    remove(cache.get_file(other).c_str());
+}
+
+void gted_test::test_helix_tree()
+{
+    vector<rna_tree> rnas = {
+        rna_tree(BRACKETS1, CONSTRAINTS, LABELS1, "1"),
+        rna_tree(BRACKETS31, CONSTRAINTS, LABELS31, "31"),
+        rna_tree(BRACKETS32, CONSTRAINTS, LABELS32, "32"),
+        rna_tree(BRACKETS51, CONSTRAINTS, LABELS51, "51"),
+    };
+    auto costs = make_shared<helix_costs>();
+    
+    // root, helix and 4 unpaired bases
+    rna_tree rna51(BRACKETS51, CONSTRAINTS, LABELS51, "51");
+    helix_tree h51(rna51);
+    assert_equals(h51.get_tree().size(), 6);
+    assert_equals(h51.get_tree().get_brackets(), "(....)");
+    assert_equals(h51.get_nodes(4).size(), 4);
+    
+    // root, helix and loop segment of 4 bases
+    helix_tree l51(rna51, true);
+    assert_equals(l51.get_tree().size(), 3);
+    assert_equals(l51.get_tree().get_brackets(), "(.)");
+    assert_equals(l51.get_nodes(0).size(), 4);
+    
+    for (bool loops : {false, true})
+    for (const rna_tree& rna1 : rnas)
+        for (const rna_tree& rna2 : rnas)
+        {
+            helix_tree h1(rna1, loops);
+            helix_tree h2(rna2, loops);
+            strategy_table_type STR(h1.get_tree().size(), h2.get_tree().size(), RTED_T1_LEFT);
+            gted g(h1.get_tree(), h2.get_tree());
+            g.set_costs(costs);
+            g.run(STR);
+            mapping map = helix_tree::expand(g.get_mapping(), h1, h2);
+            
+            // every original node is mapped exactly once
+            vector<size_t> count1(rna1.size() + 1, 0), count2(rna2.size() + 1, 0);
+            for (const auto& pair : map.map)
+            {
+                ++count1[pair.from];
+                ++count2[pair.to];
+            }
+            for (size_t i = 1; i < count1.size(); ++i)
+                assert_equals(count1[i], 1);
+            for (size_t i = 1; i < count2.size(); ++i)
+                assert_equals(count2[i], 1);
+            assert_equals(rna1.size() + map.get_to_insert().size(), rna2.size() + map.get_to_remove().size());
+            if (&rna1 == &rna2)
+                assert_equals(map.distance, 0);
+        }
+    
+    // shortening helix by 2 pairs costs less than deleting them one by one
+    rna_tree rna52(BRACKETS52, CONSTRAINTS, LABELS52, "52");
+    helix_tree h52(rna52);
+    strategy_table_type STR(h51.get_tree().size(), h52.get_tree().size(), RTED_T1_LEFT);
+    gted g(h51.get_tree(), h52.get_tree());
+    g.set_costs(costs);
+    g.run(STR);
+    assert_equals(g.get_distance(), costs->helix + costs->stacked);
+    
+    // inner pairs (postorder ids 4 and 5) are deleted together
+    mapping map = helix_tree::expand(g.get_mapping(), h51, h52);
+    assert_equals(map.distance, 2);
+    assert_true(map.get_to_remove() == mapping::indexes({5, 6}));
+}
+
+void gted_test::test_coarse_ted()
+{
+    vector<rna_tree> rnas = {
+        rna_tree(BRACKETS1, CONSTRAINTS, LABELS1, "1"),
+        rna_tree(BRACKETS31, CONSTRAINTS, LABELS31, "31"),
+        rna_tree(BRACKETS32, CONSTRAINTS, LABELS32, "32"),
+        rna_tree(BRACKETS51, CONSTRAINTS, LABELS51, "51"),
+        rna_tree(BRACKETS52, CONSTRAINTS, LABELS52, "52"),
+    };
+    
+    for (const rna_tree& rna1 : rnas)
+        for (const rna_tree& rna2 : rnas)
+        {
+            strategy_table_type STR(rna1.size(), rna2.size(), RTED_T1_LEFT);
+            gted g(rna1, rna2);
+            g.run(STR);
+            
+            coarse_ted coarse(rna1, rna2);
+            coarse.run(1, 0);
+            assert_equals(coarse.get_refined(), 0);
+            size_t coarse_distance = coarse.get_mapping().distance;
+            assert_equals(coarse.get_coarse_distance(), coarse_distance);
+            
+            // refinement never makes mapping worse nor better than exact one
+            coarse.run();
+            const mapping& map = coarse.get_mapping();
+            assert_true(g.get_distance() <= map.distance && map.distance <= coarse_distance);
+            assert_equals(rna1.size() + map.get_to_insert().size(), rna2.size() + map.get_to_remove().size());
+            if (&rna1 == &rna2)
+                assert_equals(coarse_distance, 0);
+        }
+}
@@ -22,6 +22,7 @@
 
 #include "rna_tree.test.hpp"
 #include "rna_tree.hpp"
+#include "rna_tree_snapshot.hpp"
 
 
 #define LABELS          "1234565731"
@@ -33,6 +34,9 @@
 
 #define INDEX       2
 
+// pseudoknots of 2nd and 3rd order, [[ ]] nested in one another
+#define PK_BRACKETS     "((.[[.)).{.]].}A.a"
+
 
 using namespace std;
 
@@ -67,6 +71,105 @@ void rna_tree_test::run()
 
     assert_equals(rna.get_labels(), LABELS);
     assert_equals(rna.get_brackets(), BRACKETS);
+
+    // copies are cloned into their own arena
+    rna_tree copy(rna);
+    rna_tree assigned(BRACKETS_DEL, CONSTRAINTS, LABELS_DEL);
+
+    assigned = copy;
+    copy.erase(plusplus(copy.begin(), INDEX));
+
+    assert_equals(copy.get_labels(), LABELS_DEL);
+    assert_equals(copy.get_brackets(), BRACKETS_DEL);
+    for (const rna_tree* other : {&rna, &assigned})
+    {
+        assert_equals(other->get_labels(), LABELS);
+        assert_equals(other->get_brackets(), BRACKETS);
+    }
+
+    // ids are indexed by set_postorder_ids, erase/insert drop the index,
+    // copies index their own nodes
+    assert_fail(rna.node_by_id(0));
+    assert_fail(assigned.node_by_id(0));
+    rna.set_postorder_ids();
+    rna_tree indexed_copy(rna);
+    assigned = rna;
+    for (rna_tree* indexed : {&rna, &indexed_copy, &assigned})
+    {
+        bool found = true;
+        
+        for (it = indexed->begin(); it != indexed->end(); ++it)
+            found = found && indexed->node_by_id(::id(it)) == it;
+        assert_true(found);
+        assert_true(indexed->node_by_id(indexed->size() - 1) == indexed->begin());
+        assert_fail(indexed->node_by_id(indexed->size()));
+    }
+    indexed_copy.erase(plusplus(indexed_copy.begin(), INDEX));
+    assert_fail(indexed_copy.node_by_id(0));
+
+    // residues in sequence order with 5' and 3' ends of the root
+    rna_tree_snapshot snapshot(rna);
+    const size_t none = RNA_TREE_SNAPSHOT_NONE;
+    string labels;
+
+    assert_equals(snapshot.nodes(), rna.size());
+    assert_equals(snapshot.residues(), string(LABELS).size() + 2);
+    for (size_t r = 1; r + 1 < snapshot.residues(); ++r)
+        labels += snapshot.label[r];
+    assert_equals(labels, LABELS);
+    // (.(.(.).)) - pairs 1-10, 3-9, 5-7
+    assert_equals(snapshot.partner[1], 10);
+    assert_equals(snapshot.partner[9], 3);
+    assert_equals(snapshot.partner[2], none);
+    size_t v = snapshot.node[5];
+    assert_true(snapshot.paired(v) && !snapshot.leaf(v));
+    assert_equals(snapshot.first_child[v], snapshot.node[6]);
+    assert_equals(snapshot.next_sibling[snapshot.node[6]], none);
+    assert_equals(snapshot.parent[v], snapshot.node[3]);
+    assert_equals(snapshot.next_sibling[snapshot.node[3]], none);
+    assert_equals(snapshot.parent[snapshot.node[0]], none);
+    assert_true(!snapshot.initiated(v) && snapshot.center(v).bad());
+
+    // inline labels
+    rna_pair_label pair = rna_pair_label("A") + rna_pair_label("U");
+    rna_pair_label same = pair;
+
+    assert_true(pair.paired() && pair[1].label == "U" && pair == same);
+    assert_fail(rna_pair_label("A")[1]);
+    assert_fail(label_text(string(LABEL_TEXT_CAPACITY, 'A')));
+    assert_true(interned_string("21a") == interned_string(string("21") + "a"));
+    assert_equals(interned_string("21a").str(), "21a");
+    assert_true(interned_string("").empty());
+    same.set_bounding_objects(rectangle(point(0, 0), point(1, 1)));
+    same.add_bounding_objects(rectangle(point(1, 1), point(2, 2)));
+    assert_equals(same.get_bounding_objects().size(), 2);
+    assert_true(pair.get_bounding_objects().empty());
+
+    // pair table, pairs 0-7, 1-6, 3-12, 4-11, 9-14, 15-17
+    pair_table pairs(PK_BRACKETS);
+
+    assert_equals(pairs.size(), string(PK_BRACKETS).size());
+    assert_equals(pairs[0].partner, 7);
+    assert_equals(pairs[6].partner, 1);
+    assert_equals(pairs[3].partner, 12);
+    assert_equals(pairs[11].partner, 4);
+    assert_true(pairs[4].level == 1 && pairs[11].level == 1 && pairs[12].level == 0);
+    assert_true(pairs.opening(9) && !pairs.opening(14) && pairs.pseudoknot(14));
+    assert_equals(pair_table::bracket(pairs[17].type), 'A');
+    assert_true(!pairs.paired(2) && !pairs.pseudoknot(1));
+    assert_fail(pair_table("(()"));
+    assert_fail(pair_table(".)("));
+    assert_fail(pair_table("[(])x"));
+
+    // pseudoknotted bases are leaves keyed by their pair
+    rna_tree pk(pairs, CONSTRAINTS, string(pairs.size(), 'N'));
+    rna_tree_snapshot pk_snapshot(pk);
+
+    assert_equals(pk.size(), 17);
+    assert_equals(pk_snapshot.pseudoknot[1 + 3], pk_snapshot.pseudoknot[1 + 12]);
+    assert_true(pk_snapshot.pseudoknot[1 + 4] != pk_snapshot.pseudoknot[1 + 3]);
+    assert_equals(pk_snapshot.pseudoknot[1 + 2], 0);
+    assert_fail(rna_tree(pairs, CONSTRAINTS, "NN"));
 }
 
 
@@ -33,6 +33,8 @@
 #define LABELS22     "212"
 #define BRACKETS22   "(.)"
 
+#define CONSTRAINTS  ""
+
 using namespace std;
 
 rted_test::rted_test()
@@ -53,6 +55,137 @@ void rted_test::run()
             {
                 assert_true(str.is_left());
             });
+    test_fixed_strategy();
+    test_parallel();
+    test_subtree_rows();
+    test_t2_cost_factor();
+}
+
+void rted_test::test_fixed_strategy()
+{
+    auto create = [](size_t depth) {
+        // every level has unpaired siblings on both sides,
+        // so left and right keyroots span whole subtrees
+        string brackets;
+        for (size_t i = 0; i < depth; ++i)
+            brackets += "(.";
+        brackets += "...";
+        for (size_t i = 0; i < depth; ++i)
+            brackets += ".)";
+        return rna_tree(brackets, CONSTRAINTS, string(brackets.size(), 'A'), "nested");
+    };
+
+    {
+        // small trees
+        rna_tree rna1(BRACKETS1, CONSTRAINTS, LABELS1, "rna1");
+        rna_tree rna2(BRACKETS21, CONSTRAINTS, LABELS21, "rna2");
+        rted r(rna1, rna2);
+
+        assert_true(r.select_fixed_strategy());
+
+        const strategy_table_type& STR = r.get_strategies();
+        assert_equals(STR.rows(), rna1.size());
+        assert_equals(STR.cols(), rna2.size());
+        for (size_t i = 0; i < STR.rows(); ++i)
+            for (size_t j = 0; j < STR.cols(); ++j)
+                assert_true(STR[i][j].is_T1() && !STR[i][j].is_heavy() && STR[i][j] == STR[0][0]);
+    }
+    {
+        // uniform left/right strategy is quadratic in number of cells
+        rna_tree rna1 = create(100);
+        rna_tree rna2 = create(110);
+        rted r(rna1, rna2);
+
+        assert_true(!r.select_fixed_strategy());
+    }
+}
+
+void rted_test::test_parallel()
+{
+    auto create = [](size_t domains, const string& name) {
+        // domains of different shapes, so that T1 splits to subtrees of more sizes
+        string brackets, labels;
+        for (size_t i = 0; i < domains; ++i)
+            brackets += "((" + string(i % 3 + 1, '.') + "((...))" + string(i % 2, '.') + "(..(.).)))" + string(i % 4, '.');
+        for (size_t i = 0; i < brackets.size(); ++i)
+            labels += "ACGU"[(i * 7 + name.size()) % 4];
+        return rna_tree(brackets, CONSTRAINTS, labels, name);
+    };
+    // hash of strategies in row-major order
+    auto hash = [](const strategy_table_type& STR) {
+        uint64_t h = 0;
+        for (size_t i = 0; i < STR.rows(); ++i)
+            for (size_t j = 0; j < STR.cols(); ++j)
+                h = h * 31 + STR[i][j].to_index();
+        return h;
+    };
+    rna_tree rna1 = create(12, "rna1");
+    rna_tree rna2 = create(9, "rna_2");
+
+    rted r(rna1, rna2);
+    r.run();
+    strategy_table_type STR = r.get_strategies();
+
+    // strategies computed by sequential run() with w tables of every row
+    // and weighted T2 strategies; changes only with cost model
+    assert_equals(hash(STR), uint64_t(0x12bfb780a9feb7ea));
+
+    // every cell sees the same rows and columns before it as in sequential run
+    for (size_t threads : {2, 3, 8})
+    {
+        rted p(rna1, rna2);
+        p.run(threads);
+
+        const strategy_table_type& parallel = p.get_strategies();
+        assert_equals(parallel.rows(), STR.rows());
+        assert_equals(parallel.cols(), STR.cols());
+        for (size_t i = 0; i < STR.rows(); ++i)
+            for (size_t j = 0; j < STR.cols(); ++j)
+                assert_equals(parallel[i][j].to_index(), STR[i][j].to_index());
+    }
+}
+
+void rted_test::test_subtree_rows()
+{
+    // costs of pair (v, w) are computed only from subtrees of v and w,
+    // so the same domain at the end of bigger trees gets the same strategies
+    string domain = "((..((...))..(.(..)..).((....))))";
+    string big1 = "((.((...))..))..(((...)).)" + domain;
+    string big2 = "(..(.)..)((..(...)..))." + domain;
+    auto strategies = [](const string& brackets1, const string& brackets2) {
+        rna_tree rna1(brackets1, CONSTRAINTS, string(brackets1.size(), 'A'), "rna1");
+        rna_tree rna2(brackets2, CONSTRAINTS, string(brackets2.size(), 'A'), "rna2");
+        rted r(rna1, rna2);
+        r.run();
+        return r.get_strategies();
+    };
+    strategy_table_type small = strategies(domain, domain);
+    strategy_table_type big = strategies(big1, big2);
+
+    // without roots; domain is the last child of root in postorder
+    size_t size = small.rows() - 1;
+    size_t offset1 = big.rows() - 1 - size;
+    size_t offset2 = big.cols() - 1 - size;
+    for (size_t i = 0; i < size; ++i)
+        for (size_t j = 0; j < size; ++j)
+            assert_equals(big[offset1 + i][offset2 + j].to_index(), small[i][j].to_index());
+}
+
+void rted_test::test_t2_cost_factor()
+{
+    // one more unpaired base makes left path of T2 cheaper
+    // than left path of T1, but not by RTED_T2_COST_FACTOR_PERCENT
+    string domain = "((..((...))..(.(..)..).((....))))";
+    auto root_strategy = [](const string& brackets1, const string& brackets2) {
+        rna_tree rna1(brackets1, CONSTRAINTS, string(brackets1.size(), 'A'), "rna1");
+        rna_tree rna2(brackets2, CONSTRAINTS, string(brackets2.size(), 'A'), "rna2");
+        rted r(rna1, rna2);
+        r.run();
+        return r.get_strategies()[id(rna1.begin())][id(rna2.begin())];
+    };
+
+    for (strategy str : {root_strategy(domain, domain + "."), root_strategy(domain + ".", domain)})
+        assert_true(str.is_T1() && str.is_left());
 }
 
 template<typename funct>
@@ -63,8 +196,8 @@ void rted_test::test_rted(
                 const std::string& l2,
                 funct test_funct)
 {
-    rna_tree rna1(b1, l1, "rna1");
-    rna_tree rna2(b2, l2, "rna2");
+    rna_tree rna1(b1, CONSTRAINTS, l1, "rna1");
+    rna_tree rna2(b2, CONSTRAINTS, l2, "rna2");
     rna_tree::iterator it1, it2;
     it1 = rna_tree::first_child(rna1.begin());
     it2 = rna_tree::first_child(rna2.begin());
@@ -76,6 +209,6 @@ void rted_test::test_rted(
     r.run();
     strategy_table_type val = r.get_strategies();
 
-    test_funct(val.at(id(it1)).at(id(it2)));
+    test_funct(val[id(it1)][id(it2)]);
 }
 
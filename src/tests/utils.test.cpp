@@ -24,6 +24,8 @@
 
 #include "utils.test.hpp"
 #include "utils.hpp"
+#include "binary_table.hpp"
+#include "mapping.hpp"
 
 #define TEST_FILE "/tmp/utils-test"
 
@@ -47,6 +49,9 @@ void utils_test::run()
     test_exist_file();
     test_io();
     test_read_fasta_file();
+    test_string_edit_distance();
+    test_tables();
+    test_mapping_tables();
 }
 
 void utils_test::test_exist_file()
@@ -78,6 +83,131 @@ void utils_test::test_read_fasta_file()
     assert_fail(read_fasta_file(TEST_FILE));
 }
 
+void utils_test::test_string_edit_distance()
+{
+    assert_equals(string_edit_distance("", ""), 0);
+    assert_equals(string_edit_distance("((..))", ""), 6);
+    assert_equals(string_edit_distance("((..))", "((..))"), 0);
+    assert_equals(string_edit_distance("((..))", "(.(..))"), 1);
+    assert_equals(string_edit_distance("kitten", "sitting"), 3);
+    assert_equals(string_edit_distance("(((...)))", "..((...))"), 3);
+    assert_equals(string_edit_distance("(((...)))..", "..((...))"), 5);
+
+    // bigger distances are cut to limit + 1
+    assert_equals(string_edit_distance("kitten", "sitting", 3), 3);
+    assert_equals(string_edit_distance("kitten", "sitting", 2), 3);
+    assert_equals(string_edit_distance("kitten", "sitting", 0), 1);
+    assert_equals(string_edit_distance("((..))", "", 2), 3);
+    assert_equals(string_edit_distance("(((...)))..", "..((...))", 4), 5);
+    assert_equals(string_edit_distance("(((...)))..", "..((...))", 1), 2);
+}
+
+void utils_test::test_tables()
+{
+    strategy_table_type strategies(3, 4);
+    vector<vector<size_t>> distances(3, vector<size_t>(4));
+
+    for (size_t i = 0; i < 3; ++i)
+        for (size_t j = 0; j < 4; ++j)
+        {
+            strategies[i][j] = strategy(int((i * 4 + j) % (RTED_T2_HEAVY + 1)));
+            distances[i][j] = i * 1000 + j;
+        }
+
+    // text and binary formats are loaded the same way
+    for (bool binary : {false, true})
+    {
+        save_strategy_table(TEST_FILE, strategies, binary);
+        assert_equals(binary_table::is_binary(TEST_FILE), binary);
+        strategy_table_type loaded = load_strategy_table(TEST_FILE);
+        assert_equals(loaded.rows(), 3);
+        assert_equals(loaded.cols(), 4);
+        for (size_t i = 0; i < 3; ++i)
+            for (size_t j = 0; j < 4; ++j)
+                assert_equals(loaded[i][j].to_index(), strategies[i][j].to_index());
+
+        save_tree_distance_table(TEST_FILE, distances, binary);
+        assert_true(load_tree_distance_table(TEST_FILE) == distances);
+    }
+
+    binary_table table(TEST_FILE);
+    assert_equals(table.width(), 2);
+    assert_equals(table.at(2, 3), 2003);
+
+    // truncated payload
+    string data = read_file(TEST_FILE);
+    write_file(TEST_FILE, data.substr(0, data.size() - 1));
+    assert_fail(load_tree_distance_table(TEST_FILE));
+
+    // 2-byte elements and unknown strategies are not strategies
+    write_file(TEST_FILE, data);
+    assert_fail(load_strategy_table(TEST_FILE));
+    save_strategy_table(TEST_FILE, strategies, true);
+    data = read_file(TEST_FILE);
+    data.back() = char(RTED_T2_HEAVY + 1);
+    write_file(TEST_FILE, data);
+    assert_fail(load_strategy_table(TEST_FILE));
+    write_file(TEST_FILE, data.substr(0, data.size() - 1));
+    assert_fail(load_strategy_table(TEST_FILE));
+}
+
+void utils_test::test_mapping_tables()
+{
+    mapping map;
+
+    map.distance = 2;
+    map.map = {{0, 2, 1}, {1, 1, 0}, {2, 0, 2}, {3, 3, 1}};
+
+    for (bool ndjson : {false, true})
+    {
+        save_tree_mapping_table(TEST_FILE, map, ndjson);
+        mapping loaded = load_mapping_table(TEST_FILE);
+        assert_equals(loaded.distance, 2);
+        assert_equals(loaded.map.size(), 4);
+        for (size_t i = 0; i < 4; ++i)
+        {
+            assert_equals(loaded.map[i].from, map.map[i].from);
+            assert_equals(loaded.map[i].to, map.map[i].to);
+            // only NDJSON carries costs
+            assert_equals(loaded.map[i].cost, ndjson ? map.map[i].cost : 0);
+        }
+    }
+
+    // streamed pairs come unsorted
+    {
+        mapping_writer writer(TEST_FILE);
+        for (size_t i = map.map.size(); i-- != 0;)
+            writer.write(map.map[i]);
+        writer.finish();
+    }
+    mapping loaded = load_mapping_table(TEST_FILE);
+    assert_equals(loaded.map[0].type(), mapping::insert);
+    assert_equals(loaded.map[2].type(), mapping::remove);
+    assert_equals(loaded.map[3].cost, 1);
+
+    // closing line holds sum of costs
+    string data = read_file(TEST_FILE);
+    assert_true(data.find("{\"distance\":4}") != string::npos);
+
+    // any valid JSON is accepted, malformed is not
+    write_file(TEST_FILE, "{ \"version\": 1, \"format\": \"traveler-mapping\" }\n"
+               "{\"cost\": 1, \"to\": 2, \"from\": 0, \"op\": \"insert\"}\n\n"
+               "{\"distance\": 1}\n");
+    loaded = load_mapping_table(TEST_FILE);
+    assert_equals(loaded.map.size(), 1);
+    assert_equals(loaded.map[0].to, 2);
+    write_file(TEST_FILE, "{\"format\":\"traveler-mapping\",\"version\":1}\n"
+               "{\"op\":\"insert\",\"from\":0,\"to\":\"2\",\"cost\":1}\n"
+               "{\"distance\":1}\n");
+    assert_fail(load_mapping_table(TEST_FILE));
+
+    // stream without distance is not finished
+    write_file(TEST_FILE, data.substr(0, data.rfind("{\"distance")));
+    assert_fail(load_mapping_table(TEST_FILE));
+
+    assert_true(is_ndjson_file("out.ndjson") && is_ndjson_file("out.jsonl") && !is_ndjson_file("out.map"));
+}
+
 fasta utils_test::create_fasta()
 {
     fasta f;
@@ -0,0 +1,74 @@
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+#include "label_text.hpp"
+#include "types.hpp"
+
+using namespace std;
+
+void label_text::assign(
+                        const char* s,
+                        size_t n)
+{
+    if (n >= LABEL_TEXT_CAPACITY)
+        throw wrong_argument_exception("Label '%s' is longer than %s characters",
+                                       string(s, n), LABEL_TEXT_CAPACITY - 1);
+
+    memcpy(text, s, n);
+    text[n] = '\0';
+    length = uint8_t(n);
+}
+
+
+namespace
+{
+    struct string_pool
+    {
+        string_pool()
+        {
+            strings.emplace_back();
+            indexes.emplace(strings.back(), 0);
+        }
+
+        mutex lock;
+        // deque does not move stored strings when growing
+        deque<string> strings;
+        unordered_map<string, uint32_t> indexes;
+    };
+
+    string_pool& pool()
+    {
+        static string_pool instance;
+
+        return instance;
+    }
+}
+
+interned_string::interned_string(
+                                 const string& s)
+{
+    if (s.empty())
+        return;
+
+    string_pool& p = pool();
+    lock_guard<mutex> guard(p.lock);
+    auto it = p.indexes.find(s);
+
+    if (it != p.indexes.end())
+    {
+        index = it->second;
+        return;
+    }
+    index = uint32_t(p.strings.size());
+    p.strings.push_back(s);
+    p.indexes.emplace(s, index);
+}
+
+const string& interned_string::str() const
+{
+    string_pool& p = pool();
+    lock_guard<mutex> guard(p.lock);
+
+    return p.strings[index];
+}
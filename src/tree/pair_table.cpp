@@ -0,0 +1,89 @@
+#include <algorithm>
+
+#include "pair_table.hpp"
+#include "types.hpp"
+
+#define BRACKET_TYPES   (sizeof(PAIR_TABLE_BRACKETS) / 2)
+#define INVALID         -2
+#define DOT             -1
+
+using namespace std;
+
+namespace
+{
+    /**
+     * character -> 2 * bracket type (+ 1 if closing), DOT or INVALID
+     */
+    struct bracket_codes
+    {
+        bracket_codes()
+        {
+            for (int& c : codes)
+                c = INVALID;
+            codes['.'] = DOT;
+            for (size_t i = 0; PAIR_TABLE_BRACKETS[i] != 0; ++i)
+                codes[(unsigned char)PAIR_TABLE_BRACKETS[i]] = int(i);
+        }
+
+        int codes[256];
+    };
+}
+
+pair_table::pair_table(
+                       const string& brackets)
+{
+    static const bracket_codes lookup;
+    // top of stack of every type is the last unmatched opening bracket,
+    // partner of an unmatched one is the opening bracket below it
+    uint32_t top[BRACKET_TYPES];
+    uint32_t depth[BRACKET_TYPES] = {};
+
+    if (brackets.size() >= PAIR_TABLE_UNPAIRED)
+        throw wrong_argument_exception("Dot-bracket structure of length %s is too long", brackets.size());
+
+    fill(top, top + BRACKET_TYPES, PAIR_TABLE_UNPAIRED);
+    entries.resize(brackets.size());
+
+    for (uint32_t i = 0; i < brackets.size(); ++i)
+    {
+        int code = lookup.codes[(unsigned char)brackets[i]];
+
+        if (code == DOT)
+            continue;
+        if (code == INVALID)
+            throw wrong_argument_exception("Invalid dot-bracket character '%s' at index %s", brackets[i], i);
+
+        size_t type = size_t(code) / 2;
+        entry& e = entries[i];
+
+        e.type = uint8_t(type);
+        if (code % 2 == 0)
+        {
+            e.partner = top[type];
+            e.level = depth[type]++;
+            top[type] = i;
+            continue;
+        }
+        if (top[type] == PAIR_TABLE_UNPAIRED)
+            throw wrong_argument_exception("Unmatched closing bracket '%s' at index %s", brackets[i], i);
+
+        entry& open = entries[top[type]];
+
+        e.partner = top[type];
+        e.level = --depth[type];
+        top[type] = open.partner;
+        open.partner = i;
+    }
+
+    for (size_t type = 0; type < BRACKET_TYPES; ++type)
+        if (top[type] != PAIR_TABLE_UNPAIRED)
+            throw wrong_argument_exception("Unmatched opening bracket '%s' at index %s", bracket(type), top[type]);
+}
+
+/* static */ char pair_table::bracket(
+                                     size_t type)
+{
+    assert(type < BRACKET_TYPES);
+
+    return PAIR_TABLE_BRACKETS[2 * type];
+}
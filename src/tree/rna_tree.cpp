@@ -26,6 +26,7 @@
 #include <algorithm>
 
 #include "rna_tree.hpp"
+#include "rna_tree_snapshot.hpp"
 #include "utils.hpp"
 
 using namespace std;
@@ -36,15 +37,23 @@ using namespace std;
 inline static std::vector<rna_pair_label> convert(
                                                   const std::string& labels,
                                                   const std::string& constraints,
-                                                    const std::string& brackets);
+                                                  const pair_table& pairs);
 
 rna_tree::rna_tree(
                    const std::string& _brackets,
                    const std::string& _constraints,
                    const std::string& _labels,
                    const std::string& _name)
+: rna_tree(pair_table(_brackets), _constraints, _labels, _name)
+{ }
+
+rna_tree::rna_tree(
+                   const pair_table& _pairs,
+                   const std::string& _constraints,
+                   const std::string& _labels,
+                   const std::string& _name)
 : tree_base<rna_pair_label>(
-                            _brackets, convert(_labels, _constraints, _brackets)), _name(_name)
+                            _pairs, convert(_labels, _constraints, _pairs)), _name(_name)
 
 {
     set_postorder_ids();
@@ -100,44 +109,24 @@ void rna_tree::set_name(
 std::vector<rna_pair_label> convert(
                                     const std::string& labels,
                                     const std::string& constraints,
-                                    const std::string& brackets)
+                                    const pair_table& pairs)
 {
-    //TODO: Currently this actually works for only 1st level pseudoknots
+    if (labels.size() != pairs.size())
+        throw wrong_argument_exception("Number of labels %s does not match length of structure %s",
+                                       labels.size(), pairs.size());
+
     vector<rna_pair_label> vec;
     vec.reserve(labels.size());
-    std::map<char, size_t> pk_map;
 
-    string pn_chars = string(PSEUDOKNOT_CHARACTERS);
     for (size_t i = 0; i < labels.size(); ++i)
     {
-        char symbol = brackets[i];
-
         bool de_novo = false;
         if (!constraints.empty() && constraints[i] == '*') de_novo = true;
 
-        int ix_pn = pn_chars.find(symbol);
-        string pn = "";
-        if (ix_pn != string::npos) {
-            char pk_key;
-            if (ix_pn % 2 == 0) { //first residue in the base pair
-                pk_key = pn_chars[ix_pn];
-            } else { //second residue in the base pair
-                pk_key = pn_chars[ix_pn-1]; //pn_key always represents the opening bracket
-            }
-
-            if(ix_pn % 2 == 0) //opening bracket
-            {
-                if (pk_map.count(pk_key) == 0) { //if the current bracket type is not yet  in the map
-                    pk_map.emplace(pk_key, 0);
-                }
-                pn = to_string(pk_key) + to_string(pk_map[pk_key]);
-                pk_map[pk_key]++;
-            } else
-            { //closing bracket
-                pk_map[pk_key]--;
-                pn = to_string(pk_key) + to_string(pk_map[pk_key]);
-            }
-        }
+        // both bases of pseudoknot pair are keyed by code of opening bracket and its nesting level
+        char pn[32] = "";
+        if (pairs.pseudoknot(i))
+            snprintf(pn, sizeof(pn), "%d%u", int(pair_table::bracket(pairs[i].type)), unsigned(pairs[i].level));
 
         vec.emplace_back(rna_pair_label(labels.substr(i, 1), de_novo, pn));
     }
@@ -256,6 +245,7 @@ rna_tree::sibling_iterator rna_tree::erase(
     assert(is_leaf(del));
     _tree.erase(del);
     --_size;
+    invalidate_ids();
     
     return sib;
 }
@@ -279,6 +269,7 @@ rna_tree::sibling_iterator rna_tree::insert(
     
     _tree.reparent(pos, beg, end);
     ++_size;
+    invalidate_ids();
     
     return pos;
 }
@@ -415,23 +406,36 @@ rna_tree::iterator rna_tree::get_rightest_initiated_descendant(const rna_tree::i
 
 void rna_tree::compute_distances()
 {
+    rna_tree_snapshot rna(*this);
+    const size_t none = RNA_TREE_SNAPSHOT_NONE;
     int cnt;
     double dist;
+    size_t v, ch;
+    
+    // node has exactly one paired child
+    auto onlyone_branch = [&rna, none](size_t v) {
+        size_t count = 0;
+        for (size_t ch = rna.first_child[v]; ch != none; ch = rna.next_sibling[ch])
+            count += rna.paired(ch);
+        return count == 1;
+    };
     
     // compute distances between 2 pairs (CG <-> CG)
     cnt = 0;
     dist = 0;
-    for (iterator it = begin(); it != end(); ++it)
+    for (v = 0; v < rna.nodes(); ++v)
     {
-        if (!it->initiated_points()
-            || is_root(it)
-            || is_leaf(it)
-            || !is_valid(get_onlyone_branch(parent(it)))
-            || !rna_tree::is_only_child(it)
-            || parent(it)->center().bad()) //can happen when the parent of a base pair is the 3'5'
+        size_t parent = rna.parent[v];
+        
+        if (!rna.initiated(v)
+            || parent == none
+            || rna.leaf(v)
+            || !onlyone_branch(parent)
+            || rna.first_child[parent] != v || rna.next_sibling[v] != none
+            || rna.center(parent).bad()) //can happen when the parent of a base pair is the 3'5'
             continue;
         
-        dist += distance(parent(it)->center(), it->center());
+        dist += distance(rna.center(parent), rna.center(v));
         DEBUG("dist=%s", dist);
         ++cnt;
     }
@@ -440,13 +444,13 @@ void rna_tree::compute_distances()
     // distance between bases in pair (C <-> G)
     cnt = 0;
     dist = 0;
-    for (iterator it = begin(); it != end(); ++it)
+    for (v = 0; v < rna.nodes(); ++v)
     {
-        if (!it->initiated_points()
-            || is_leaf(it))
+        if (!rna.initiated(v)
+            || rna.leaf(v))
             continue;
         
-        dist += distance(it->at(0).p, it->at(1).p);
+        dist += distance(rna.p(rna.residue[v]), rna.p(rna.partner[rna.residue[v]]));
         ++cnt;
     }
     distances.base_pair_distance = dist / (double)cnt;
@@ -454,22 +458,26 @@ void rna_tree::compute_distances()
     // distance between unpaired bases in loops
     cnt = 0;
     dist = 0;
-    for (iterator it = begin(); it != end(); ++it)
+    for (v = 0; v < rna.nodes(); ++v)
     {
-        if (!it->initiated_points())
+        if (!rna.initiated(v))
             continue;
         
-        sibling_iterator end = it.end();
-        for (sibling_iterator ch = it.begin(); ch != end; ++ch)
+        // after each run of leaves, the next child is skipped
+        for (ch = rna.first_child[v]; ch != none; ch = rna.next_sibling[ch])
         {
-            sibling_iterator prev;
-            while (is_leaf(prev = ch++)
-                   && ch != end
-                   && is_leaf(ch))
+            size_t prev;
+            while (rna.leaf(prev = ch)
+                   && (ch = rna.next_sibling[ch]) != none
+                   && rna.leaf(ch))
             {
-                dist += distance(prev->center(), ch->center());
+                dist += distance(rna.center(prev), rna.center(ch));
                 ++cnt;
             }
+            if (!rna.leaf(prev))
+                ch = rna.next_sibling[ch];
+            if (ch == none)
+                break;
         }
     }
     distances.loops_bases_distance = dist / (double)cnt;
@@ -479,18 +487,19 @@ void rna_tree::compute_distances()
     point p, p_prev;
     vector<double> dists;
     vector<double> stem_dists;
-    for (pre_post_order_iterator it = ++this->begin_pre_post(); it != this->end_pre_post(); ++it, ++cnt){
-        if (it.node->parent == NULL) {
+    for (size_t r = 1; r < rna.residues(); ++r, ++cnt){
+        v = rna.node[r];
+        if (rna.parent[v] == none) {
             //the artificial root
             continue;
         }
-        p = it->at(it.label_index()).p;
+        p = rna.p(r);
         if (cnt) {
             dists.push_back(distance(p_prev, p));
             dist += distance(p_prev, p);
 
-            auto parent = it.node->parent;
-            if (it->paired() && parent->first_child == parent->last_child){
+            size_t parent = rna.parent[v];
+            if (rna.paired(v) && rna.next_sibling[rna.first_child[parent]] == none){
                 stem_dists.push_back(distance(p_prev, p));
             }
         }
@@ -663,12 +672,10 @@ void rna_tree::update_bounding_boxes(bool leafs_have_size){
 }
 
 rna_pair_label rna_tree::get_node_by_id(const int id) {
-    for (post_order_iterator it = this->begin_post(); it != this->end_post(); ++it) {
-        if (it->id() == id) {
-            return it.node->data;
-        }
-    }
-    assert(false);
+    if (id < 0)
+        throw wrong_argument_exception("No node with id %s", id);
+
+    return *node_by_id(id);
 }
 
 void rna_tree::update_numbering_labels(const vector<string> &numbering_labels){
@@ -39,9 +39,8 @@ rna_pair_label::rna_pair_label()
 rna_pair_label::rna_pair_label(
                                const std::string s)
 {
-    rna_label l;
-    l.label = s;
-    labels.push_back(l);
+    labels[0].label = s;
+    labels_count = 1;
 }
 
 rna_pair_label::rna_pair_label(
@@ -59,15 +58,12 @@ const rna_label& rna_pair_label::operator[](
 {
     assert(index == 0 || index == 1);
     
-    try
-    {
-        return labels.at(index);
-    }
-    catch (const out_of_range& e)
+    if (index >= labels_count)
     {
         ERR("Trying to get label at illegal index %s; labels=%s", index, *this);
-        throw;
+        throw out_of_range("rna_pair_label: illegal label index");
     }
+    return labels[index];
 }
 
 rna_label& rna_pair_label::operator[](
@@ -75,15 +71,12 @@ rna_label& rna_pair_label::operator[](
 {
     assert(index == 0 || index == 1);
     
-    try
-    {
-        return labels.at(index);
-    }
-    catch (const out_of_range& e)
+    if (index >= labels_count)
     {
         ERR("Trying to get label at illegal index %s; labels=%s", index, *this);
-        throw;
+        throw out_of_range("rna_pair_label: illegal label index");
     }
+    return labels[index];
 }
 
 const rna_label& rna_pair_label::at(
@@ -101,10 +94,10 @@ rna_label& rna_pair_label::at(
 bool rna_pair_label::operator==(
                                 const rna_pair_label& other) const
 {
-    if (labels.size() != other.labels.size())
+    if (labels_count != other.labels_count)
         return false;
     
-    for (size_t i = 0; i < labels.size(); ++i)
+    for (size_t i = 0; i < labels_count; ++i)
         if (labels[i] != other.labels[i])
             return false;
     
@@ -117,8 +110,9 @@ rna_pair_label rna_pair_label::operator+(
     assert(!paired() && !other.paired());
     
     rna_pair_label out;
-    out.labels.push_back(labels.back());
-    out.labels.push_back(other.labels.back());
+    out.labels[0] = labels[labels_count - 1];
+    out.labels[1] = other.labels[other.labels_count - 1];
+    out.labels_count = 2;
     out.de_novo_predicted = this->de_novo_predicted || other.de_novo_predicted;
     
     return out;
@@ -156,8 +150,8 @@ break;
     
     out << status;
     
-    for (const auto& val : lbl.labels)
-        out << val.label;
+    for (size_t i = 0; i < lbl.labels_count; ++i)
+        out << lbl.labels[i].label;
     
     if (!status.empty())
         out << "`";
@@ -190,21 +184,21 @@ std::ostream& operator<<(
 
 size_t rna_pair_label::size() const
 {
-    return (size_t)labels.size();
+    return (size_t)labels_count;
 }
 
 bool rna_pair_label::paired() const
 {
 
-    assert(labels.size() == 1 || labels.size() == 2);
+    assert(labels_count == 1 || labels_count == 2);
     
-    return labels.size() == 2;
+    return labels_count == 2;
 }
 
 bool rna_pair_label::initiated_points() const
 {
-    for (const auto& lbl : labels)
-        if (lbl.p.bad())
+    for (size_t i = 0; i < labels_count; ++i)
+        if (labels[i].p.bad())
             return false;
     return true;
 }
@@ -224,8 +218,8 @@ point rna_pair_label::center() const
 
 void rna_pair_label::clear_points()
 {
-    for (auto& val : labels)
-        val.p = point::bad_point();
+    for (size_t i = 0; i < labels_count; ++i)
+        labels[i].p = point::bad_point();
 }
 
 void rna_pair_label::set_label_strings(
@@ -263,7 +257,7 @@ void rna_pair_label::set_label_strings(
     for (size_t i = 0; i < n; ++i) {
         if (i >= 1 && !this->paired()) {
             //situation when paired node (last bp in a stem with no loop) is mapped on non-paired node
-            (*this).labels.push_back(other[i]);
+            labels[labels_count++] = other[i];
         } else {
             (*this)[i].tmp_label = (*this)[i].label;
             (*this)[i].label = other[i].label;
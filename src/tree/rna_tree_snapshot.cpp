@@ -0,0 +1,97 @@
+#include <map>
+
+#include "rna_tree_snapshot.hpp"
+
+using namespace std;
+
+rna_tree_snapshot::rna_tree_snapshot(
+                                     rna_tree& rna)
+{
+    APP_DEBUG_FNAME;
+
+    size_t n = rna.size();
+    // paired nodes entered and not left yet, innermost last
+    vector<size_t> open;
+    vector<size_t> last_child(n, RNA_TREE_SNAPSHOT_NONE);
+    map<string, size_t> pseudoknots;
+
+    parent.reserve(n);
+    first_child.reserve(n);
+    next_sibling.reserve(n);
+    residue.reserve(n);
+    id.reserve(n);
+    status.reserve(n);
+
+    for (rna_tree::pre_post_order_iterator it = rna.begin_pre_post(); it != rna.end_pre_post(); ++it)
+    {
+        size_t index = it.label_index();
+        size_t r = node.size();
+        size_t v;
+
+        if (index == 0)
+        {
+            v = parent.size();
+            parent.push_back(open.empty() ? RNA_TREE_SNAPSHOT_NONE : open.back());
+            first_child.push_back(RNA_TREE_SNAPSHOT_NONE);
+            next_sibling.push_back(RNA_TREE_SNAPSHOT_NONE);
+            residue.push_back(r);
+            id.push_back(it->id());
+            status.push_back(uint8_t(it->status));
+
+            size_t u = parent.back();
+            if (u != RNA_TREE_SNAPSHOT_NONE)
+            {
+                if (last_child[u] == RNA_TREE_SNAPSHOT_NONE)
+                    first_child[u] = v;
+                else
+                    next_sibling[last_child[u]] = v;
+                last_child[u] = v;
+            }
+            if (it->paired())
+                open.push_back(v);
+            partner.push_back(RNA_TREE_SNAPSHOT_NONE);
+        }
+        else
+        {
+            assert(!open.empty());
+            v = open.back();
+            open.pop_back();
+            partner[residue[v]] = r;
+            partner.push_back(residue[v]);
+        }
+
+        const rna_label& lbl = it->at(index);
+
+        x.push_back(lbl.p.x);
+        y.push_back(lbl.p.y);
+        label.push_back(lbl.label.empty() ? ' ' : lbl.label[0]);
+        node.push_back(v);
+        seq_ix.push_back(lbl.seq_ix);
+        if (lbl.pseudoknot.empty())
+            pseudoknot.push_back(0);
+        else
+            pseudoknot.push_back(pseudoknots.emplace(lbl.pseudoknot.str(), pseudoknots.size() + 1).first->second);
+    }
+    assert(open.empty() && parent.size() == n);
+}
+
+bool rna_tree_snapshot::initiated(
+                                  size_t v) const
+{
+    size_t r = residue[v];
+
+    return !p(r).bad() && (partner[r] == RNA_TREE_SNAPSHOT_NONE || !p(partner[r]).bad());
+}
+
+point rna_tree_snapshot::center(
+                                size_t v) const
+{
+    size_t r = residue[v];
+
+    if (!initiated(v))
+        return point::bad_point();
+    if (paired(v))
+        return ::center(p(r), p(partner[r]));
+    else
+        return p(r);
+}
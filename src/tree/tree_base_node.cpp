@@ -26,22 +26,15 @@
 using namespace std;
 
 /* static */
-size_t node_base::ID = 0;
+std::atomic<size_t> node_base::ID(0);
 
 size_t node_base::id() const
 {
     return _id;
 }
 
-void node_base::reset_id()
+void node_base::set_id(
+                       size_t id)
 {
-    _id = ID++;
-}
-
-/* static */
-void node_base::reset_ID()
-{
-    INFO("Reseting tree IDs");
-    
-    ID = 0;
+    _id = id;
 }
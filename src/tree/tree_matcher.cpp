@@ -25,9 +25,6 @@
 
 using namespace std;
 
-#define set_remake(iter) \
-rna_tree::parent(iter)->remake_ids.push_back(child_index(iter));
-
 //maps trees
 matcher::matcher(
                  const rna_tree& templated,
@@ -54,16 +51,19 @@ rna_tree& matcher::run(
 //        i = index;
 //    }
 
+    mapping::indexes to_remove = map.get_to_remove();
+    mapping::indexes to_insert = map.get_to_insert();
+
     //Sizes of the trees after deletion from one and insertion into the other should match
-    if (t1.size() - map.get_to_remove().size() != t2.size() - map.get_to_insert().size())
+    if (t1.size() - to_remove.size() != t2.size() - to_insert.size())
     {
         throw illegal_state_exception("Target and template tree sizes after insertions and deletions  do not match");
     }
 
 
     
-    mark(t1, map.get_to_remove(), rna_pair_label::deleted); //t1 is template -> remove extra nodes
-    mark(t2, map.get_to_insert(), rna_pair_label::inserted); //t2 is target -> add nodes which are missing in template
+    mark(t1, to_remove, rna_pair_label::deleted); //t1 is template -> remove extra nodes
+    mark(t2, to_insert, rna_pair_label::inserted); //t2 is target -> add nodes which are missing in template
 
     // T1 is a template which has removed and inserted nodes so it now fits the structure of target. To this tree
     // we will now add target-template position mapping
@@ -81,7 +81,7 @@ rna_tree& matcher::run(
         it->at(it.label_index()).tmp_ix = i;
     }
 
-    //remove nodes from t1 and mark this in parent using set_remake
+    //remove nodes from t1 and mark this in remake_ids of parent
     erase();
     
     t1.set_postorder_ids();
@@ -113,18 +113,16 @@ void matcher::mark(
                    const indexes_type& postorder_indexes,
                    rna_pair_label::status_type status)
 {
-    post_order_iterator it = rna.begin_post();
-    size_t i = 0;
+    // mapping refers to nodes by postorder ids
+    if (!rna.has_ids_index())
+        rna.set_postorder_ids();
     
     for (size_t index : postorder_indexes)
     {
-        --index;    // indexed from one
-        size_t to_move = index - i;
-        it = plusplus(it, to_move);
+        iterator it = rna.node_by_id(index - 1);    // indexed from one
         
         assert(!rna_tree::is_root(it));
         it->status = status;
-        i = index;
     }
     
     rna.print_tree();
@@ -134,9 +132,12 @@ void matcher::erase()
 {
     iterator it;
     sibling_iterator ch;
+    size_t index;
     
     for (it = t1.begin(); it != t1.end(); ++it)
     {
+        // position of ch among children of it, deleted ones are gone yet
+        index = 0;
         for (ch = it.begin(); ch != it.end();)
         {
             if (is(ch, rna_pair_label::deleted))
@@ -145,12 +146,14 @@ void matcher::erase()
                  * Set Information for the drawing algorithm that descendants will need to be moved
                  * and siblings (loop) will need to be repositioned on the circle
                  */
-                set_remake(ch);
+                it->remake_ids.push_back(index);
+                // children of ch take its position
                 ch = t1.erase(ch);
                 
                 continue;
             }
             ++ch;
+            ++index;
         }
     }
 }
@@ -161,7 +164,7 @@ void matcher::merge(const mapping &map)
 {
     iterator it1, it2;
     sibling_iterator ch1, ch2, ins;
-    size_t actual, needed, steal;
+    size_t actual, needed, steal, index;
     
     it1 = t1.begin();
     it2 = t2.begin();
@@ -172,6 +175,7 @@ void matcher::merge(const mapping &map)
     {
         ch1 = it1.begin();
         ch2 = it2.begin();
+        index = 0;  // position of ch1 among children of it1
 
         while (ch2 != it2.end())
         {
@@ -200,7 +204,7 @@ void matcher::merge(const mapping &map)
                 }
                 ch1 = t1.insert(ins, *ch2, steal);
                 ch1->clear_points();
-                set_remake(ch1);
+                it1->remake_ids.push_back(index);
             }
             else
             {
@@ -209,6 +213,7 @@ void matcher::merge(const mapping &map)
             
             ++ch2;
             ++ch1;
+            ++index;
         }
         
         assert(ch1 == it1.end() && ch2 == it2.end());
@@ -0,0 +1,196 @@
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "binary_table.hpp"
+
+using namespace std;
+
+static uint64_t get(
+                    const uint8_t* in,
+                    size_t width)
+{
+    uint64_t value = 0;
+
+    for (size_t i = width; i-- > 0;)
+        value = (value << 8) | in[i];
+
+    return value;
+}
+
+binary_table::binary_table(
+                           const std::string& filename)
+{
+    APP_DEBUG_FNAME;
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat st;
+
+    if (fd < 0)
+        throw io_exception("binary_table(%s) failed, file can not be opened", filename);
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < BINARY_TABLE_HEADER_SIZE)
+    {
+        close(fd);
+        throw io_exception("binary_table(%s) failed, file is too short", filename);
+    }
+
+    length = st.st_size;
+    address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED)
+    {
+        address = nullptr;
+        throw io_exception("binary_table(%s) failed, file can not be mapped", filename);
+    }
+
+    const uint8_t* header = static_cast<const uint8_t*>(address);
+    const char* error = parse_header(header, length, m, n, w);
+
+    payload = header + BINARY_TABLE_HEADER_SIZE;
+    if (error != nullptr)
+    {
+        munmap(address, length);
+        address = nullptr;
+        throw io_exception("binary_table(%s) failed, %s", filename, error);
+    }
+
+    DEBUG("binary_table(%s): %sx%s, width %s", filename, m, n, w);
+}
+
+binary_table::~binary_table()
+{
+    if (address != nullptr)
+        munmap(address, length);
+}
+
+/* static */ const char* binary_table::parse_header(
+                                                   const uint8_t* header,
+                                                   size_t length,
+                                                   size_t& rows,
+                                                   size_t& cols,
+                                                   size_t& width)
+{
+    uint64_t version = get(header + 8, 4);
+
+    width = get(header + 12, 4);
+    rows = get(header + 16, 8);
+    cols = get(header + 24, 8);
+
+    if (memcmp(header, BINARY_TABLE_MAGIC, 8) != 0)
+        return "not a binary table";
+    if (version != BINARY_TABLE_VERSION)
+        return "unsupported version";
+    if (width != 1 && width != 2 && width != 4 && width != 8)
+        return "unsupported element width";
+    if (cols != 0 && rows > (length - BINARY_TABLE_HEADER_SIZE) / width / cols)
+        return "payload is too short";
+    if (BINARY_TABLE_HEADER_SIZE + rows * cols * width != length)
+        return "payload size does not match dimensions";
+
+    return nullptr;
+}
+
+/* static */ void binary_table::open_payload(
+                                             const std::string& filename,
+                                             std::ifstream& in,
+                                             size_t& rows,
+                                             size_t& cols,
+                                             size_t& width)
+{
+    uint8_t header[BINARY_TABLE_HEADER_SIZE];
+    struct stat st;
+
+    in.open(filename, ios::binary);
+    if (!in || stat(filename.c_str(), &st) != 0)
+        throw io_exception("binary_table(%s) failed, file can not be opened", filename);
+    if (size_t(st.st_size) < BINARY_TABLE_HEADER_SIZE ||
+        !in.read(reinterpret_cast<char*>(header), sizeof(header)))
+        throw io_exception("binary_table(%s) failed, file is too short", filename);
+
+    const char* error = parse_header(header, st.st_size, rows, cols, width);
+
+    if (error != nullptr)
+        throw io_exception("binary_table(%s) failed, %s", filename, error);
+}
+
+/* static */ bool binary_table::is_binary(
+                                          const std::string& filename)
+{
+    char magic[8] = {};
+    ifstream in(filename, ios::binary);
+
+    in.read(magic, sizeof(magic));
+
+    return in.good() && memcmp(magic, BINARY_TABLE_MAGIC, sizeof(magic)) == 0;
+}
+
+/* static */ size_t binary_table::width_for(
+                                            uint64_t max_value)
+{
+    if (max_value <= UINT8_MAX)
+        return 1;
+    if (max_value <= UINT16_MAX)
+        return 2;
+    if (max_value <= UINT32_MAX)
+        return 4;
+    return 8;
+}
+
+uint64_t binary_table::at(
+                          size_t i,
+                          size_t j) const
+{
+    assert(i < m && j < n);
+
+    return get(payload + (i * n + j) * w, w);
+}
+
+/* static */ void binary_table::save(
+                                     const std::string& filename,
+                                     size_t rows,
+                                     size_t cols,
+                                     size_t width,
+                                     const std::vector<uint8_t>& payload)
+{
+    APP_DEBUG_FNAME;
+    DEBUG("save: %s", filename);
+
+    assert(width == 1 || width == 2 || width == 4 || width == 8);
+
+    uint8_t header[BINARY_TABLE_HEADER_SIZE];
+
+    memcpy(header, BINARY_TABLE_MAGIC, 8);
+    put(header + 8, BINARY_TABLE_VERSION, 4);
+    put(header + 12, width, 4);
+    put(header + 16, rows, 8);
+    put(header + 24, cols, 8);
+
+    ofstream out(filename, ios::binary);
+
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+
+    if (out.fail())
+        throw io_exception("binary_table::save(%s) failed", filename);
+}
+
+/* static */ void binary_table::put(
+                                    uint8_t* out,
+                                    uint64_t value,
+                                    size_t width)
+{
+    assert(width == 8 || value >> (8 * width) == 0);
+
+    for (size_t i = 0; i < width; ++i, value >>= 8)
+        out[i] = uint8_t(value);
+}
+
+/* static */ bool binary_table::little_endian()
+{
+    const uint16_t one = 1;
+
+    return *reinterpret_cast<const uint8_t*>(&one) == 1;
+}
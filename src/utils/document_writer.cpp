@@ -446,32 +446,28 @@ void document_writer::validate_stream() const
         throw io_exception("Writing document failed");
 }
 
-vector<point> document_writer::get_residues_positions(rna_tree &rna) const{
+vector<point> document_writer::get_residues_positions(const rna_tree_snapshot &rna) const{
 
     vector<point> points;
-    auto extract_point =
-            [&points](rna_tree::pre_post_order_iterator it)
-            {
-                points.push_back(it->at(it.label_index()).p);
-            };
 
-    rna_tree::for_each_in_subtree(rna.begin_pre_post(), extract_point);
+    points.reserve(rna.residues());
+    for (size_t r = 0; r < rna.residues(); ++r)
+        points.push_back(rna.p(r));
     return points;
 }
 
-vector<pair<point, point>> document_writer::get_lines(rna_tree &rna) const{
+vector<pair<point, point>> document_writer::get_lines(const rna_tree_snapshot &rna) const{
 
     vector<pair<point, point>> lines;
-    auto extract_line =
-            [&lines](rna_tree::pre_post_order_iterator it)
-            {
-                if (it->paired()) {
-                    lines.push_back(make_pair(it->at(0).p, it->at(1).p));
-                }
 
-            };
+    // every pair once for each of its residues
+    for (size_t r = 0; r < rna.residues(); ++r) {
+        size_t first = rna.residue[rna.node[r]];
 
-    rna_tree::for_each_in_subtree(rna.begin(), extract_line);
+        if (rna.partner[first] != RNA_TREE_SNAPSHOT_NONE) {
+            lines.push_back(make_pair(rna.p(first), rna.p(rna.partner[first])));
+        }
+    }
     return lines;
 }
 
@@ -481,16 +477,17 @@ std::string document_writer::get_rna_subtree_formatted(
                                                        const pseudoknots& pn) const
 {
     ostringstream out;
-    vector<point> residues_positions = get_residues_positions(rna);
-    vector<pair<point, point>> lines = get_lines(rna);
+    rna_tree_snapshot snapshot(rna);
+    vector<point> residues_positions = get_residues_positions(snapshot);
+    vector<pair<point, point>> lines = get_lines(snapshot);
     int seq_ix = 0;
     auto print =
     [&rna, &out, &seq_ix, &residues_positions, &lines, &numbering, this](rna_tree::pre_post_order_iterator it)
     {
         out << get_label_formatted(it, {seq_ix,
-                                        it->at(it.label_index()).tmp_label,
+                                        it->at(it.label_index()).tmp_label.str(),
                                         it->at(it.label_index()).tmp_ix,
-                                        it->at(it.label_index()).tmp_numbering_label});
+                                        it->at(it.label_index()).tmp_numbering_label.str()});
         out << get_numbering_formatted(it, seq_ix, rna.get_seq_distance_median(), residues_positions, lines, numbering);
         seq_ix++;
     };
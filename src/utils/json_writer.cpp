@@ -144,8 +144,9 @@ std::string json_writer::get_rna_subtree_formatted(
 {
     json structure = json::parse(R"({"rnaComplexes": [{"name": "complex","rnaMolecules": [{"name": "molecule","sequence": [],"basePairs": [], "labels":[] }]}]})");
 
-    vector<point> residues_positions = get_residues_positions(rna);
-    vector<pair<point, point>> lines = get_lines(rna);
+    rna_tree_snapshot snapshot(rna);
+    vector<point> residues_positions = get_residues_positions(snapshot);
+    vector<pair<point, point>> lines = get_lines(snapshot);
 
     json json_sequence;
     json json_labels;
@@ -161,15 +162,15 @@ std::string json_writer::get_rna_subtree_formatted(
                 point p = map_point(it->at(it.label_index()).p, false);
                 json residue;
                 residue["residueIndex"] = seq_ix;
-                residue["residueName"] = it->at(it.label_index()).label;
+                residue["residueName"] = it->at(it.label_index()).label.str();
                 residue["x"] = p.x;
                 residue["y"] = p.y;
                 residue["classes"] = {msprintf("text-%s", get_default_color(it->status).get_name())};
 
                 json info;
-                info["templateResidueName"] = it->at(it.label_index()).tmp_label;
+                info["templateResidueName"] = it->at(it.label_index()).tmp_label.str();
                 info["templateResidueIndex"] = it->at(it.label_index()).tmp_ix;
-                info["templateNumberingLabel"] = it->at(it.label_index()).tmp_numbering_label;
+                info["templateNumberingLabel"] = it->at(it.label_index()).tmp_numbering_label.str();
                 residue["info"] = info;
 
                 json_sequence.push_back(residue);
@@ -206,7 +207,7 @@ std::string json_writer::get_rna_subtree_formatted(
                     }
                     point p = map_point(label_def.label.p, false);
                     label["labelContent"] = {
-                            {"label", label_def.label.label},
+                            {"label", label_def.label.label.str()},
                             {"x", p.x},
                             {"y", p.y},
                             {"classes", {}}
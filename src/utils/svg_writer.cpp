@@ -265,7 +265,7 @@ public:
     //<< property("class", color.get_name());
             << property("class", clazz);
     
-    return create_element("text", out, label.label, li);
+    return create_element("text", out, label.label.str(), li);
 }
 
 
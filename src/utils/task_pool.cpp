@@ -0,0 +1,196 @@
+#include <algorithm>
+
+#include "task_pool.hpp"
+
+using namespace std;
+
+// pool owning current thread and thread's index in it
+static thread_local const task_pool* current_pool = nullptr;
+static thread_local size_t current_index = 0;
+
+task_pool::task_pool(
+                     size_t _threads)
+: queued(0)
+{
+    size_t i;
+
+    if (_threads == 0)
+        _threads = 1;
+
+    for (i = 0; i < _threads; ++i)
+        queues.emplace_back(new queue());
+    for (i = 1; i < _threads; ++i)
+        threads.emplace_back(&task_pool::work, this, i);
+}
+
+task_pool::~task_pool()
+{
+    {
+        lock_guard<mutex> guard(sleep_lock);
+        stop = true;
+    }
+    sleep.notify_all();
+
+    for (thread& t : threads)
+        t.join();
+}
+
+size_t task_pool::thread_index() const
+{
+    return current_pool == this ? current_index : 0;
+}
+
+void task_pool::push(
+                     entry e)
+{
+    queue& q = *queues[thread_index()];
+
+    {
+        lock_guard<mutex> guard(q.lock);
+        q.tasks.push_back(move(e));
+    }
+    ++queued;
+    {
+        // sleeping thread checks `queued` under this lock, so it cannot miss it
+        lock_guard<mutex> guard(sleep_lock);
+    }
+    sleep.notify_one();
+}
+
+bool task_pool::run_one(
+                        size_t index,
+                        const task_group* only)
+{
+    entry e;
+    bool found = false;
+    size_t i;
+
+    for (i = 0; i < queues.size() && !found; ++i)
+    {
+        queue& q = *queues[(index + i) % queues.size()];
+        lock_guard<mutex> guard(q.lock);
+
+        if (q.tasks.empty())
+            continue;
+
+        if (only != nullptr)
+        {
+            auto it = find_if(q.tasks.begin(), q.tasks.end(), [only](const entry& value) {
+                return value.group == only;
+            });
+            if (it == q.tasks.end())
+                continue;
+            e = move(*it);
+            q.tasks.erase(it);
+        }
+        else if (i == 0)
+        {
+            // own queue: newest task, its data are likely in cache
+            e = move(q.tasks.back());
+            q.tasks.pop_back();
+        }
+        else
+        {
+            // steal oldest, i.e. biggest task
+            e = move(q.tasks.front());
+            q.tasks.pop_front();
+        }
+        found = true;
+    }
+
+    if (!found)
+        return false;
+
+    --queued;
+
+    exception_ptr error;
+    try
+    {
+        e.task();
+    }
+    catch (...)
+    {
+        error = current_exception();
+    }
+    e.group->finished(error);
+
+    return true;
+}
+
+void task_pool::work(
+                     size_t index)
+{
+    current_pool = this;
+    current_index = index;
+
+    while (true)
+    {
+        if (run_one(index))
+            continue;
+
+        unique_lock<mutex> guard(sleep_lock);
+        sleep.wait(guard, [this]() {
+            return stop || queued != 0;
+        });
+        if (stop && queued == 0)
+            return;
+    }
+}
+
+task_pool::task_group::task_group(
+                                  task_pool& _pool)
+: pool(_pool), pending(0)
+{ }
+
+task_pool::task_group::~task_group()
+{
+    try
+    {
+        wait();
+    }
+    catch (...)
+    { }
+}
+
+void task_pool::task_group::run(
+                                task_type task)
+{
+    if (pool.size() == 1)
+    {
+        task();
+        return;
+    }
+
+    ++pending;
+    pool.push({move(task), this});
+}
+
+void task_pool::task_group::wait(
+                                 bool run_others)
+{
+    while (pending != 0)
+    {
+        if (!pool.run_one(pool.thread_index(), run_others ? nullptr : this))
+            this_thread::yield();
+    }
+
+    exception_ptr e;
+    {
+        lock_guard<mutex> guard(error_lock);
+        swap(e, error);
+    }
+    if (e)
+        rethrow_exception(e);
+}
+
+void task_pool::task_group::finished(
+                                     exception_ptr e)
+{
+    if (e)
+    {
+        lock_guard<mutex> guard(error_lock);
+        if (!error)
+            error = e;
+    }
+    --pending;
+}
@@ -21,8 +21,15 @@
 
 
 #include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "json.hpp"
 
 #include "utils.hpp"
+#include "binary_table.hpp"
 #include "mapping.hpp"
 #include "exception.hpp"
 
@@ -70,6 +77,87 @@ bool contains_one_of(
         throw io_exception("write_file(%s) failed", filename);
 }
 
+/* global */ bool is_directory(
+                               const std::string& path)
+{
+    struct stat s;
+    
+    return stat(path.c_str(), &s) == 0 && S_ISDIR(s.st_mode);
+}
+
+/* global */ std::vector<std::string> list_directory(
+                                                   const std::string& dirname)
+{
+    vector<string> files;
+    DIR* dir = opendir(dirname.c_str());
+    
+    if (dir == nullptr)
+        throw io_exception("list_directory(%s) failed, cannot open directory", dirname);
+    
+    for (dirent* entry = readdir(dir); entry != nullptr; entry = readdir(dir))
+    {
+        string name = entry->d_name;
+        
+        if (name != "." && name != "..")
+            files.push_back(name);
+    }
+    closedir(dir);
+    
+    sort(files.begin(), files.end());
+    
+    return files;
+}
+
+/* global */ size_t string_edit_distance(
+                                        const std::string& s1,
+                                        const std::string& s2,
+                                        size_t limit)
+{
+    const size_t n = s1.size();
+    const size_t m = s2.size();
+    
+    limit = min(limit, max(n, m));
+    if ((n > m ? n - m : m - n) > limit)
+        return limit + 1;
+    
+    // only cells with |i - j| <= limit can be at most limit
+    const size_t over = limit + 1;
+    vector<size_t> prev(m + 1, over), cur(m + 1, over);
+    size_t i, j;
+    
+    for (j = 0; j <= min(m, limit); ++j)
+        prev[j] = j;
+    for (i = 1; i <= n; ++i)
+    {
+        size_t lo = i > limit ? i - limit : 0;
+        size_t hi = min(m, i + limit);
+        size_t row_min = over;
+        
+        if (lo > 0)
+            cur[lo - 1] = over;
+        for (j = lo; j <= hi; ++j)
+        {
+            size_t value = prev[j] + 1;
+            if (j == 0)
+                value = i;
+            else
+            {
+                value = min(value, cur[j - 1] + 1);
+                value = min(value, prev[j - 1] + (s1[i - 1] == s2[j - 1] ? 0 : 1));
+            }
+            cur[j] = min(value, over);
+            row_min = min(row_min, cur[j]);
+        }
+        if (hi < m)
+            cur[hi + 1] = over;
+        if (row_min == over)
+            return over;
+        swap(prev, cur);
+    }
+    
+    return prev[m];
+}
+
 /* inline, local */ std::string trim(
         std::string s)
 {
@@ -237,16 +325,44 @@ void save_table(
         throw io_exception("save_table(%s) failed", filename);
 }
 
+template <typename table_type, typename table_value_type = size_t>
+table_type load_binary_table(
+                             const std::string& filename)
+{
+    APP_DEBUG_FNAME;
+    
+    binary_table binary(filename);
+    table_type table(binary.rows(), typename table_type::value_type(binary.cols()));
+    
+    for (size_t i = 0; i < binary.rows(); ++i)
+        for (size_t j = 0; j < binary.cols(); ++j)
+            table[i][j] = table_value_type(binary.at(i, j));
+    
+    return table;
+}
+
 
 
 
 void save_strategy_table(
                          const std::string& filename,
-                         const strategy_table_type& table)
+                         const strategy_table_type& table,
+                         bool binary)
 {
     APP_DEBUG_FNAME;
     
-    save_table<strategy_table_type, strategy, size_t>(filename, table);
+    if (binary)
+        binary_table::save(filename, table, table.rows(), table.cols(), 1);
+    else
+    {
+        // text format is for debugging, temporary copy does not matter
+        std::vector<std::vector<size_t>> indexes(table.rows(), std::vector<size_t>(table.cols()));
+        
+        for (size_t i = 0; i < table.rows(); ++i)
+            for (size_t j = 0; j < table.cols(); ++j)
+                indexes[i][j] = table[i][j];
+        save_table<std::vector<std::vector<size_t>>>(filename, indexes);
+    }
 }
 
 strategy_table_type load_strategy_table(
@@ -254,17 +370,55 @@ strategy_table_type load_strategy_table(
 {
     APP_DEBUG_FNAME;
     
-    return load_table<strategy_table_type, strategy>(filename);
+    if (binary_table::is_binary(filename))
+    {
+        // one-byte strategy is stored as its index, so the payload is read
+        // straight into the table and only checked afterwards
+        static_assert(sizeof(strategy) == 1, "strategy has to be stored in one byte");
+        strategy_table_type table;
+        
+        binary_table::read(filename, table);
+        
+        const uint8_t* indexes = reinterpret_cast<const uint8_t*>(table.data());
+        
+        for (size_t i = 0; i < table.rows() * table.cols(); ++i)
+            if (indexes[i] > RTED_T2_HEAVY)
+                throw io_exception("load_strategy_table(%s) failed, wrong strategy %s", filename, size_t(indexes[i]));
+        
+        return table;
+    }
+    
+    std::vector<std::vector<size_t>> indexes = load_table<std::vector<std::vector<size_t>>>(filename);
+    strategy_table_type table(indexes.size(), indexes.empty() ? 0 : indexes[0].size());
+    
+    for (size_t i = 0; i < table.rows(); ++i)
+        for (size_t j = 0; j < table.cols(); ++j)
+            table[i][j] = strategy(int(indexes[i][j]));
+    
+    return table;
 }
 
 void save_tree_distance_table(
                               const std::string& filename,
-                              const std::vector<std::vector<size_t>>& table)
+                              const std::vector<std::vector<size_t>>& table,
+                              bool binary)
 {
     APP_DEBUG_FNAME;
     typedef std::vector<std::vector<size_t>> tree_distance_table_type;
     
-    save_table<tree_distance_table_type>(filename, table);
+    if (binary)
+    {
+        size_t max_value = 0;
+        
+        for (const auto& row : table)
+            for (size_t value : row)
+                max_value = max(max_value, value);
+        
+        binary_table::save(filename, table, table.size(), table.empty() ? 0 : table[0].size(),
+                           binary_table::width_for(max_value));
+    }
+    else
+        save_table<tree_distance_table_type>(filename, table);
 }
 
 std::vector<std::vector<size_t>> load_tree_distance_table(
@@ -273,6 +427,9 @@ std::vector<std::vector<size_t>> load_tree_distance_table(
     APP_DEBUG_FNAME;
     typedef std::vector<std::vector<size_t>> tree_distance_table_type;
     
+    if (binary_table::is_binary(filename))
+        return load_binary_table<tree_distance_table_type>(filename);
+    
     return load_table<tree_distance_table_type>(filename);
 }
 
@@ -280,10 +437,22 @@ std::vector<std::vector<size_t>> load_tree_distance_table(
 
 void save_tree_mapping_table(
                              const std::string& filename,
-                             const mapping& map)
+                             const mapping& map,
+                             bool ndjson)
 {
     APP_DEBUG_FNAME;
     
+    if (ndjson)
+    {
+        mapping_writer writer(filename);
+        
+        for (const auto& m : map.map)
+            writer.write(m);
+        writer.finish();
+        
+        return;
+    }
+    
     DEBUG("save: %s", filename);
     ofstream out(filename);
     
@@ -305,6 +474,64 @@ void save_tree_mapping_table(
         throw io_exception("save_table(%s) failed", filename);
 }
 
+/**
+ * load mapping_writer stream from `in`, pairs are sorted as in the text
+ * format and distance is the number of inserted and deleted nodes
+ */
+static mapping load_mapping_ndjson(
+                                   std::istream& in,
+                                   const std::string& filename)
+{
+    string line;
+    mapping map;
+    bool finished = false;
+    
+    map.distance = 0;
+    try
+    {
+        if (!getline(in, line) ||
+            nlohmann::json::parse(line).value("format", "") != MAPPING_NDJSON_FORMAT)
+            throw io_exception("load_mapping_table(%s) failed, not a mapping stream", filename);
+        
+        while (getline(in, line))
+        {
+            if (line.find_first_not_of(" \t\r") == string::npos)
+                continue;
+            
+            nlohmann::json object = nlohmann::json::parse(line);
+            
+            if (!object.is_object())
+                throw io_exception("load_mapping_table(%s) failed, invalid line '%s'", filename, line);
+            if (object.count("op") == 0)
+            {
+                finished = finished || object.count("distance") != 0;
+                continue;
+            }
+            
+            mapping::mapping_pair m(object.at("from").get<size_t>(),
+                                    object.at("to").get<size_t>(),
+                                    object.at("cost").get<size_t>());
+            
+            if (object.at("op").get<string>() != mapping_writer::operation_name(m.type()))
+                throw io_exception("load_mapping_table(%s) failed, invalid pair '%s'", filename, line);
+            
+            map.map.push_back(m);
+            map.distance += m.type() != mapping::update;
+        }
+    }
+    catch (const nlohmann::json::exception& e)
+    {
+        throw io_exception("load_mapping_table(%s) failed, invalid line '%s': %s", filename, line, e.what());
+    }
+    
+    if (!finished)
+        throw io_exception("load_mapping_table(%s) failed, stream is not finished", filename);
+    
+    sort(map.map.begin(), map.map.end());
+    
+    return map;
+}
+
 mapping load_mapping_table(
                            const std::string& filename)
 {
@@ -318,6 +545,9 @@ mapping load_mapping_table(
     mapping::mapping_pair m;
     ifstream in(filename);
     
+    if (in.peek() == '{')
+        return load_mapping_ndjson(in, filename);
+    
     in
     >> s
     >> map.distance;
@@ -339,6 +569,21 @@ mapping load_mapping_table(
     return map;
 }
 
+bool is_ndjson_file(
+                    const std::string& filename)
+{
+    for (const char* extension : {".ndjson", ".jsonl"})
+    {
+        size_t length = strlen(extension);
+        
+        if (filename.size() >= length &&
+            filename.compare(filename.size() - length, string::npos, extension) == 0)
+            return true;
+    }
+    
+    return false;
+}
+
 
 
 